@@ -36,6 +36,10 @@ extern "C"
     MaaControllerHandle MAA_FRAMEWORK_API MaaCustomControllerCreate(MaaCustomControllerHandle handle,
                                                                     MaaControllerCallback callback,
                                                                     MaaCallbackTransparentArg callback_arg);
+    // Same as MaaCustomControllerCreate, and screencaps through raw_image_handle->get_raw_image when it is set.
+    MaaControllerHandle MAA_FRAMEWORK_API MaaCustomControllerCreateWithRawImage(
+        MaaCustomControllerHandle handle, MaaCustomControllerRawImageHandle raw_image_handle,
+        MaaControllerCallback callback, MaaCallbackTransparentArg callback_arg);
     MaaControllerHandle MAA_FRAMEWORK_API MaaThriftControllerCreate(MaaString param, MaaControllerCallback callback,
                                                                     MaaCallbackTransparentArg callback_arg);
 
@@ -58,6 +62,15 @@ extern "C"
     MaaSize MAA_FRAMEWORK_API MaaControllerGetImage(MaaControllerHandle ctrl, void* buff, MaaSize buff_size);
     MaaSize MAA_FRAMEWORK_API MaaControllerGetUUID(MaaControllerHandle ctrl, char* buff, MaaSize buff_size);
 
+    // The encoded image is cached per frame, asking for the same frame again costs nothing.
+    // If buff is null, return the size needed; else return written size.
+    MaaSize MAA_FRAMEWORK_API MaaControllerGetImageEncoded(MaaControllerHandle ctrl, MaaImageEncoding encoding,
+                                                           void* buff, MaaSize buff_size);
+    // Raw pixels without encoding, rows are tightly packed. width, height and format are always filled.
+    // If buff is null, return the size needed; else return written size.
+    MaaSize MAA_FRAMEWORK_API MaaControllerGetImageRaw(MaaControllerHandle ctrl, int32_t* width, int32_t* height,
+                                                       MaaImageFormat* format, void* buff, MaaSize buff_size);
+
     /* Instance */
 
     MaaInstanceHandle MAA_FRAMEWORK_API MaaCreate(MaaInstanceCallback callback, MaaCallbackTransparentArg callback_arg);
@@ -71,6 +84,12 @@ extern "C"
 
     MaaBool MAA_FRAMEWORK_API MaaRegisterCustomRecognizer(MaaInstanceHandle inst, MaaString name,
                                                           MaaCustomRecognizerHandle recognizer);
+    // Same as MaaRegisterCustomRecognizer, with detail_buff of detail_buff_size bytes instead of
+    // MaaRecognitionResultDetailBuffSize. 0 means the default, larger than MaaRecognitionResultDetailBuffMaxSize is
+    // clamped to it.
+    MaaBool MAA_FRAMEWORK_API MaaRegisterCustomRecognizerWithDetailSize(MaaInstanceHandle inst, MaaString name,
+                                                                        MaaCustomRecognizerHandle recognizer,
+                                                                        MaaSize detail_buff_size);
     MaaBool MAA_FRAMEWORK_API MaaUnregisterCustomRecognizer(MaaInstanceHandle inst, MaaString name);
     MaaBool MAA_FRAMEWORK_API MaaClearCustomRecognizer(MaaInstanceHandle inst);
 
@@ -99,6 +118,12 @@ extern "C"
     void MAA_FRAMEWORK_API MaaSyncContextSwipe(MaaSyncContextHandle sync_context, int32_t* x_steps_buff,
                                                int32_t* y_steps_buff, int32_t* step_delay_buff, MaaSize buff_size);
     MaaSize MAA_FRAMEWORK_API MaaSyncContextScreencap(MaaSyncContextHandle sync_context, void* buff, MaaSize buff_size);
+    // If buff is null, screencap and return the size needed; else write the latest image without screencap.
+    MaaSize MAA_FRAMEWORK_API MaaSyncContextScreencapEncoded(MaaSyncContextHandle sync_context,
+                                                             MaaImageEncoding encoding, void* buff, MaaSize buff_size);
+    MaaSize MAA_FRAMEWORK_API MaaSyncContextScreencapRaw(MaaSyncContextHandle sync_context, int32_t* width,
+                                                         int32_t* height, MaaImageFormat* format, void* buff,
+                                                         MaaSize buff_size);
     MaaSize MAA_FRAMEWORK_API MaaSyncContextGetTaskResult(MaaSyncContextHandle sync_context, MaaString task, char* buff,
                                                           MaaSize buff_size);
 
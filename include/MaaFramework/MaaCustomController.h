@@ -26,6 +26,17 @@ extern "C"
         MaaSize (*get_uuid)(char* buff, MaaSize buff_size);
     };
 
+    // Passed to MaaCustomControllerCreateWithRawImage, kept apart from MaaCustomControllerAPI so that
+    // controllers built against older headers are not read past the end of their struct.
+    struct MAA_FRAMEWORK_API MaaCustomControllerRawImageAPI
+    {
+        // used instead of get_image when not null.
+        // write the current screen as width * height pixels into buff, whose rows are stride bytes apart
+        // (stride >= width * 4), and set *format to one of MaaImageFormatEnum.
+        // width and height are the size the framework expects, scale the image to it if needed.
+        MaaBool (*get_raw_image)(int32_t width, int32_t height, MaaSize stride, uint8_t* buff, MaaImageFormat* format);
+    };
+
 #ifdef __cplusplus
 }
 #endif
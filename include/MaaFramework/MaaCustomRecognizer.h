@@ -16,24 +16,34 @@ extern "C"
         int32_t height;
     };
 
+    // A view into the captured frame, no copy is made. Only valid during analyze, copy it if you need it
+    // after returning.
     struct MAA_FRAMEWORK_API MaaImage
     {
         int32_t rows;
         int32_t cols;
         int32_t type;
-        void* data;
+        // shared with the controller and other recognizers, never write through it
+        const void* data;
+        // bytes between the starts of two adjacent rows, may be larger than cols * pixel size
+        MaaSize step;
     };
 
 #define MaaRecognitionResultDetailBuffSize 16384
+// upper bound of the size passed to MaaRegisterCustomRecognizerWithDetailSize
+#define MaaRecognitionResultDetailBuffMaxSize 16777216
 
     struct MAA_FRAMEWORK_API MaaRecognitionResult
     {
+        // relative to image, the framework adds the roi offset
         MaaRect box;
-        void* detail_buff; // size = MaaRecognitionResultDetailBuffSize
+        void* detail_buff; // size = detail_buff_size, write a null-terminated string
+        MaaSize detail_buff_size;
     };
 
     struct MAA_FRAMEWORK_API MaaCustomRecognizerAPI
     {
+        // Called once for each roi of the task with image being the roi sub-view, until one returns true.
         MaaBool (*analyze)(MaaSyncContextHandle sync_context, const MaaImage* image, MaaString task_name,
                            MaaJsonString custom_recognition_param,
                            /*out*/ MaaRecognitionResult* result);
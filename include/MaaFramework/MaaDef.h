@@ -76,6 +76,12 @@ enum MaaCtrlOptionEnum
     // For StopApp
     // value: string, eg: "com.hypergryph.arknights"; val_size: string length
     MaaCtrlOption_DefaultAppPackage = 4,
+
+    // Reuse the last screenshot if it was taken less than this many milliseconds ago and no other action has been
+    // posted since. Screenshot requests that arrive while another one is still queued always share its result.
+    // 0 (default) means every request waits for a new capture.
+    // value: int, eg: 100; val_size: sizeof(int)
+    MaaCtrlOption_ScreenshotMaxFrameAge = 5,
 };
 
 typedef MaaOption MaaInstOption;
@@ -107,6 +113,8 @@ enum MaaAdbControllerTypeEnum
     MaaAdbControllerType_Screencap_EncodeToFile = 5 << 16,
     MaaAdbControllerType_Screencap_MinicapDirect = 6 << 16,
     MaaAdbControllerType_Screencap_MinicapStream = 7 << 16,
+    MaaAdbControllerType_Screencap_RawStream = 8 << 16,
+    MaaAdbControllerType_Screencap_VideoStream = 9 << 16,
     MaaAdbControllerType_Screencap_Mask = 0xFF0000,
 
     MaaAdbControllerType_Input_Preset_Adb = MaaAdbControllerType_Touch_Adb | MaaAdbControllerType_Key_Adb,
@@ -115,6 +123,27 @@ enum MaaAdbControllerTypeEnum
         MaaAdbControllerType_Touch_MaaTouch | MaaAdbControllerType_Key_MaaTouch,
 };
 
+typedef int32_t MaaImageFormat;
+enum MaaImageFormatEnum
+{
+    MaaImageFormat_Invalid = 0,
+    // 3 bytes per pixel
+    MaaImageFormat_BGR = 1,
+    // 4 bytes per pixel
+    MaaImageFormat_BGRA = 2,
+    MaaImageFormat_RGBA = 3,
+};
+
+typedef int32_t MaaImageEncoding;
+enum MaaImageEncodingEnum
+{
+    MaaImageEncoding_Invalid = 0,
+    // Same as MaaControllerGetImage.
+    MaaImageEncoding_PNG = 1,
+    // https://qoiformat.org, lossless and several times faster to encode than PNG. 3 channels, size is in the header.
+    MaaImageEncoding_QOI = 2,
+};
+
 typedef void* MaaCallbackTransparentArg;
 
 typedef void (*MaaAPICallback)(MaaString msg, MaaJsonString details_json, MaaCallbackTransparentArg callback_arg);
@@ -124,6 +153,8 @@ typedef MaaAPICallback MaaInstanceCallback;
 
 struct MaaCustomControllerAPI;
 typedef struct MaaCustomControllerAPI* MaaCustomControllerHandle;
+struct MaaCustomControllerRawImageAPI;
+typedef struct MaaCustomControllerRawImageAPI* MaaCustomControllerRawImageHandle;
 
 struct MaaCustomRecognizerAPI;
 typedef struct MaaCustomRecognizerAPI* MaaCustomRecognizerHandle;
@@ -30,9 +30,18 @@ struct CustomImage {
   1: Size size,
   2: i32 type,
   3: binary data,
+  // set when the frame was written into the shared memory negotiated by set_option("shared_memory", ...);
+  // data is left empty then
+  4: optional i32 shm_slot,
+  5: optional i64 frame_id,
 }
 
 service ThriftController {
+  // key "shared_memory": value is a json {"name", "slot_count", "slot_size", "header_size"}.
+  // Open the named shared memory (shm_open on posix, OpenFileMapping on windows) and return true to accept it.
+  // Slot i starts at i * slot_size; its first 8 bytes are the frame_id (uint64, native endian), pixels follow
+  // at header_size. Set frame_id to 0 before writing pixels and to the new frame_id (> 0) after.
+  // Frames that do not fit in slot_size - header_size should be returned in CustomImage.data as usual.
   bool set_option(1: string key, 2: string value),
 
   bool connect(),
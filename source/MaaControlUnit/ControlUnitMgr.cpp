@@ -15,6 +15,8 @@
 #include "Screencap/Minicap/MinicapDirect.h"
 #include "Screencap/Minicap/MinicapStream.h"
 #include "Screencap/RawByNetcat.h"
+#include "Screencap/RawStream.h"
+#include "Screencap/VideoStream.h"
 #include "Screencap/RawWithGzip.h"
 #include "Utils/Logger.h"
 
@@ -162,6 +164,14 @@ std::shared_ptr<ControlUnitAPI> create_adb_controller_unit(MaaString adb_path, M
         LogInfo << "screencap_type: MinicapStream";
         screencap_unit = std::make_shared<MinicapStream>();
         break;
+    case MaaAdbControllerType_Screencap_RawStream:
+        LogInfo << "screencap_type: ScreencapRawStream";
+        screencap_unit = std::make_shared<ScreencapRawStream>();
+        break;
+    case MaaAdbControllerType_Screencap_VideoStream:
+        LogInfo << "screencap_type: ScreencapVideoStream";
+        screencap_unit = std::make_shared<ScreencapVideoStream>();
+        break;
     default:
         LogError << "Unknown screencap type" << VAR(screencap_type);
         return nullptr;
@@ -187,7 +197,7 @@ std::shared_ptr<ControlUnitAPI> create_adb_controller_unit(MaaString adb_path, M
         return nullptr;
     }
 
-    auto platform_io = PlatformFactory::create();
+    auto platform_io = PlatformFactory::create(adb_path);
     if (!platform_io) {
         LogError << "Create platform io failed";
         return nullptr;
@@ -221,7 +231,7 @@ std::shared_ptr<ConnectionAPI> create_adb_connection(MaaString adb_path, MaaStri
         return nullptr;
     }
 
-    auto platform_io = PlatformFactory::create();
+    auto platform_io = PlatformFactory::create(adb_path);
     if (!platform_io) {
         LogError << "Create platform io failed";
         return nullptr;
@@ -254,7 +264,7 @@ std::shared_ptr<DeviceInfoAPI> create_adb_device_info(MaaString adb_path, MaaStr
         return nullptr;
     }
 
-    auto platform_io = PlatformFactory::create();
+    auto platform_io = PlatformFactory::create(adb_path);
     if (!platform_io) {
         LogError << "Create platform io failed";
         return nullptr;
@@ -287,7 +297,7 @@ std::shared_ptr<ActivityAPI> create_adb_activity(MaaString adb_path, MaaString a
         return nullptr;
     }
 
-    auto platform_io = PlatformFactory::create();
+    auto platform_io = PlatformFactory::create(adb_path);
     if (!platform_io) {
         LogError << "Create platform io failed";
         return nullptr;
@@ -335,7 +345,7 @@ std::shared_ptr<TouchInputAPI> create_adb_touch_input(MaaString adb_path, MaaStr
         return nullptr;
     }
 
-    auto platform_io = PlatformFactory::create();
+    auto platform_io = PlatformFactory::create(adb_path);
     if (!platform_io) {
         LogError << "Create platform io failed";
         return nullptr;
@@ -379,7 +389,7 @@ std::shared_ptr<KeyInputAPI> create_adb_key_input(MaaString adb_path, MaaString
         return nullptr;
     }
 
-    auto platform_io = PlatformFactory::create();
+    auto platform_io = PlatformFactory::create(adb_path);
     if (!platform_io) {
         LogError << "Create platform io failed";
         return nullptr;
@@ -432,6 +442,14 @@ std::shared_ptr<ScreencapAPI> create_adb_screencap(MaaString adb_path, MaaString
         LogInfo << "screencap_type: MinicapStream";
         screencap_unit = std::make_shared<MinicapStream>();
         break;
+    case MaaAdbControllerType_Screencap_RawStream:
+        LogInfo << "screencap_type: ScreencapRawStream";
+        screencap_unit = std::make_shared<ScreencapRawStream>();
+        break;
+    case MaaAdbControllerType_Screencap_VideoStream:
+        LogInfo << "screencap_type: ScreencapVideoStream";
+        screencap_unit = std::make_shared<ScreencapVideoStream>();
+        break;
     default:
         LogError << "Unknown screencap type" << VAR(type);
         return nullptr;
@@ -443,7 +461,7 @@ std::shared_ptr<ScreencapAPI> create_adb_screencap(MaaString adb_path, MaaString
         return nullptr;
     }
 
-    auto platform_io = PlatformFactory::create();
+    auto platform_io = PlatformFactory::create(adb_path);
     if (!platform_io) {
         LogError << "Create platform io failed";
         return nullptr;
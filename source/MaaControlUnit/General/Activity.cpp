@@ -14,7 +14,7 @@ bool Activity::start(const std::string& intent)
     LogFunc;
 
     merge_replacement({ { "{INTENT}", intent } });
-    auto cmd_ret = command(start_app_argv_.gen(argv_replace_));
+    auto cmd_ret = shell_session_->exec(start_app_argv_.gen(argv_replace_));
 
     return cmd_ret.has_value();
 }
@@ -24,7 +24,7 @@ bool Activity::stop(const std::string& intent)
     LogFunc;
 
     merge_replacement({ { "{INTENT}", intent } });
-    auto cmd_ret = command(stop_app_argv_.gen(argv_replace_));
+    auto cmd_ret = shell_session_->exec(stop_app_argv_.gen(argv_replace_));
 
     return cmd_ret.has_value();
 }
@@ -2,11 +2,14 @@
 
 #include "UnitBase.h"
 
+#include "ShellSession.h"
+
 MAA_CTRL_UNIT_NS_BEGIN
 
 class Activity : public ActivityBase
 {
 public:
+    Activity() { children_.emplace_back(shell_session_); }
     virtual ~Activity() override = default;
 
 public: // from UnitBase
@@ -19,6 +22,8 @@ public: // from ActivityAPI
 private:
     Argv start_app_argv_;
     Argv stop_app_argv_;
+
+    std::shared_ptr<ShellSession> shell_session_ = std::make_shared<ShellSession>();
 };
 
 MAA_CTRL_UNIT_NS_END
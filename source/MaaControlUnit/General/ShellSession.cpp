@@ -0,0 +1,207 @@
+#include "ShellSession.h"
+
+#include <algorithm>
+#include <random>
+
+#include "Platform/AdbWireIO.h"
+#include "Utils/Format.hpp"
+#include "Utils/Logger.h"
+
+MAA_CTRL_UNIT_NS_BEGIN
+
+ShellSession::~ShellSession()
+{
+    close();
+}
+
+bool ShellSession::parse(const json::value& config)
+{
+    // 会话复用各命令自己的 shell 前缀，没有单独的配置
+    std::ignore = config;
+    return true;
+}
+
+std::optional<std::string> ShellSession::exec(const Argv::value& cmd, std::chrono::milliseconds timeout)
+{
+    auto id = post(cmd);
+    if (!id) {
+        return command(cmd, false, timeout.count());
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    auto result = wait(*id, timeout);
+    if (!result) {
+        // 命令可能已经执行过了，不能再起进程重来一遍
+        LogError << "shell session failed" << VAR(cmd);
+        return std::nullopt;
+    }
+
+    auto duration = duration_since(start_time);
+    LogDebug << VAR(cmd) << VAR(result->code) << VAR(result->output.size()) << VAR(duration);
+
+    if (result->code != 0) {
+        LogError << "shell command failed" << VAR(cmd) << VAR(result->code) << VAR(result->output);
+        return std::nullopt;
+    }
+    return std::move(result->output);
+}
+
+std::optional<uint64_t> ShellSession::post(const Argv::value& cmd)
+{
+    auto split = split_shell(cmd);
+    if (!split) {
+        return std::nullopt;
+    }
+    auto& [prefix, shell_cmd] = *split;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (unsupported_) {
+        return std::nullopt;
+    }
+    if ((!shell_handler_ || shell_prefix_ != prefix) && !open(prefix)) {
+        return std::nullopt;
+    }
+
+    uint64_t id = ++next_id_;
+    // stdin 接 /dev/null，免得命令把后面写进来的命令当输入读走
+    std::string line = MAA_FMT::format("{{ {}\n}} </dev/null; echo \"{} $?\"\n", shell_cmd, marker(id));
+    if (!shell_handler_->write(line)) {
+        LogWarn << "write to shell session failed, reopen next time";
+        shell_handler_ = nullptr;
+        return std::nullopt;
+    }
+    return id;
+}
+
+std::optional<ShellSession::Result> ShellSession::wait(uint64_t id, std::chrono::milliseconds timeout)
+{
+    using namespace std::chrono_literals;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        if (auto it = results_.find(id); it != results_.end()) {
+            Result result = std::move(it->second);
+            results_.erase(it);
+            return result;
+        }
+        // 会话已经重开过，这条命令的结果拿不到了
+        if (!shell_handler_ || id <= done_id_) {
+            return std::nullopt;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            LogError << "shell session timeout" << VAR(id) << VAR(timeout);
+            shell_handler_ = nullptr;
+            return std::nullopt;
+        }
+
+        auto read_start = std::chrono::steady_clock::now();
+        auto data = shell_handler_->read(1);
+        if (data.empty()) {
+            // 没等满就返回空，说明 shell 已经退出
+            if (std::chrono::steady_clock::now() - read_start < 500ms) {
+                LogError << "shell session closed" << VAR(id);
+                shell_handler_ = nullptr;
+                return std::nullopt;
+            }
+            continue;
+        }
+        buffer_ += data;
+        parse_results();
+    }
+}
+
+void ShellSession::close()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    shell_handler_ = nullptr;
+}
+
+std::optional<std::pair<ShellSession::Argv::value, std::string>> ShellSession::split_shell(const Argv::value& cmd)
+{
+    auto iter = std::find(cmd.begin(), cmd.end(), "shell");
+    if (iter == cmd.begin() || iter == cmd.end() || std::next(iter) == cmd.end() ||
+        std::next(iter)->starts_with('-')) {
+        return std::nullopt;
+    }
+
+    std::string shell_cmd;
+    for (auto arg = std::next(iter); arg != cmd.end(); ++arg) {
+        if (!shell_cmd.empty()) {
+            shell_cmd += ' ';
+        }
+        shell_cmd += *arg;
+    }
+    return std::make_pair(Argv::value(cmd.begin(), std::next(iter)), std::move(shell_cmd));
+}
+
+bool ShellSession::open(const Argv::value& prefix)
+{
+    LogFunc;
+
+    if (!io_ptr_) {
+        LogError << "io_ptr is nullptr";
+        return false;
+    }
+
+    auto argv = prefix;
+    argv.emplace_back("sh");
+    auto handler = io_ptr_->interactive_shell(argv);
+    if (!handler) {
+        LogError << "failed to open shell session" << VAR(argv);
+        return false;
+    }
+    // 进程管道的 read 要读满整块才返回，等不到结束标记
+    if (!std::dynamic_pointer_cast<IOHandlerAdbShell>(handler)) {
+        LogWarn << "shell session needs adb shell v2, fallback to one process per command";
+        unsupported_ = true;
+        return false;
+    }
+
+    shell_handler_ = std::move(handler);
+    shell_prefix_ = prefix;
+    token_ = MAA_FMT::format("{:08x}", std::random_device {}());
+    // 之前会话里没取走的结果都作废
+    done_id_ = next_id_;
+    buffer_.clear();
+    results_.clear();
+    return true;
+}
+
+void ShellSession::parse_results()
+{
+    while (true) {
+        uint64_t id = done_id_ + 1;
+        std::string mark = marker(id) + " ";
+        auto pos = buffer_.find(mark);
+        if (pos == std::string::npos) {
+            return;
+        }
+        auto end = buffer_.find('\n', pos + mark.size());
+        if (end == std::string::npos) {
+            return;
+        }
+
+        Result result;
+        result.output = buffer_.substr(0, pos);
+        try {
+            result.code = std::stoi(buffer_.substr(pos + mark.size(), end - pos - mark.size()));
+        }
+        catch (const std::exception&) {
+            result.code = -1;
+        }
+
+        buffer_.erase(0, end + 1);
+        results_.insert_or_assign(id, std::move(result));
+        done_id_ = id;
+    }
+}
+
+std::string ShellSession::marker(uint64_t id) const
+{
+    return MAA_FMT::format("__MAA_SHELL_{}_{}__", token_, id);
+}
+
+MAA_CTRL_UNIT_NS_END
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+
+#include "UnitBase.h"
+
+MAA_CTRL_UNIT_NS_BEGIN
+
+// 常驻的 adb shell 会话，把 `adb shell xxx` 形式的命令写进同一个 sh 里执行，省掉每条命令起一个进程的开销。
+// 每条命令后面跟一个带序号的结束标记，从输出里按标记切出各自的输出和退出码；连续写入的命令在设备端流水执行
+class ShellSession : public UnitBase
+{
+public:
+    struct Result
+    {
+        int code = 0;
+        std::string output;
+    };
+
+public:
+    virtual ~ShellSession() override;
+
+public: // from UnitBase
+    virtual bool parse(const json::value& config) override;
+
+public:
+    // 和 UnitBase::command 一样：退出码为 0 时返回输出；命令不是 shell 形式或会话不可用时退回单独起进程
+    std::optional<std::string> exec(const Argv::value& cmd, std::chrono::milliseconds timeout = kDefaultTimeout);
+
+    // 只写入不等待，返回序号；结果用 wait 取
+    std::optional<uint64_t> post(const Argv::value& cmd);
+    std::optional<Result> wait(uint64_t id, std::chrono::milliseconds timeout = kDefaultTimeout);
+
+    void close();
+
+private:
+    static constexpr std::chrono::milliseconds kDefaultTimeout { 20000 };
+
+    // 拆成 {ADB} -s {ADB_SERIAL} shell 前缀和要执行的命令
+    static std::optional<std::pair<Argv::value, std::string>> split_shell(const Argv::value& cmd);
+    bool open(const Argv::value& prefix);
+    void parse_results();
+    std::string marker(uint64_t id) const;
+
+    std::mutex mutex_;
+    std::shared_ptr<IOHandler> shell_handler_ = nullptr;
+    Argv::value shell_prefix_;
+    // 当前会话拿不到部分输出（进程管道只能读满整块），以后都单独起进程
+    bool unsupported_ = false;
+
+    std::string token_;
+    uint64_t next_id_ = 0;
+    uint64_t done_id_ = 0;
+    std::string buffer_;
+    std::map<uint64_t, Result> results_;
+};
+
+MAA_CTRL_UNIT_NS_END
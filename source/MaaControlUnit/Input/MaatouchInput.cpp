@@ -4,6 +4,7 @@
 #include "Utils/Logger.h"
 #include "Utils/Ranges.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 
@@ -159,40 +160,32 @@ bool MaatouchInput::click(int x, int y)
 bool MaatouchInput::swipe(const std::vector<SwipeStep>& steps)
 {
     if (!shell_handler_ || steps.size() < 2) {
+        LogError << "shell handler not ready or too few steps" << VAR(steps.size());
         return false;
     }
 
-    // 检查第一个点的位置?
-    {
-        auto first = steps[0];
-        int x = first.x, y = first.y;
-        scale_point(x, y);
-        auto now = std::chrono::steady_clock::now();
-        if (!shell_handler_->write(MAA_FMT::format("d {} {} {} {}\nc\n", 0, x, y, press_))) {
-            return false;
-        }
-        auto used = std::chrono::steady_clock::now() - now;
-        auto expect = std::chrono::milliseconds(first.delay);
-        if (used < expect) {
-            std::this_thread::sleep_for(expect - used);
+    // 一次写完，w 由 maatouch 在设备端等待，控制器线程不用陪着 sleep
+    std::string gesture;
+    int total_delay = 0;
+    for (auto it = steps.begin(); it != steps.end(); ++it) {
+        auto [x, y] = scale_point(it->x, it->y);
+        gesture += MAA_FMT::format("{} {} {} {} {}\nc\n", it == steps.begin() ? 'd' : 'm', 0, x, y, press_);
+        if (it->delay > 0) {
+            gesture += MAA_FMT::format("w {}\n", it->delay);
+            total_delay += it->delay;
         }
     }
+    gesture += MAA_FMT::format("u {}\nc\n", 0);
 
-    for (auto it = steps.begin() + 1; it != steps.end(); it++) {
-        int x = it->x, y = it->y;
-        auto now = std::chrono::steady_clock::now();
-        auto res = shell_handler_->write(MAA_FMT::format("m {} {} {} {}\nc\n", 0, x, y, press_));
-        if (!res) {
-            return false;
-        }
-        auto used = std::chrono::steady_clock::now() - now;
-        auto expect = std::chrono::milliseconds(it->delay);
-        if (used < expect) {
-            std::this_thread::sleep_for(expect - used);
-        }
+    if (!shell_handler_->write(gesture)) {
+        LogError << "swipe failed";
+        return false;
     }
 
-    return shell_handler_->write(MAA_FMT::format("u {}\nc\n", 0));
+    // 设备端按顺序执行，前一段没做完的话这段要排在它后面
+    auto gesture_start = std::max(gesture_end_.load(), std::chrono::steady_clock::now());
+    gesture_end_ = gesture_start + std::chrono::milliseconds(total_delay);
+    return true;
 }
 
 bool MaatouchInput::press_key(int key)
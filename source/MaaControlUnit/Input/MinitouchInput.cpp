@@ -4,6 +4,7 @@
 #include "Utils/Logger.h"
 #include "Utils/Ranges.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 
@@ -180,39 +181,32 @@ bool MinitouchInput::click(int x, int y)
 bool MinitouchInput::swipe(const std::vector<SwipeStep>& steps)
 {
     if (!shell_handler_ || steps.size() < 2) {
+        LogError << "shell handler not ready or too few steps" << VAR(steps.size());
         return false;
     }
 
-    // 检查第一个点的位置?
-    {
-        auto first = steps[0];
-        auto [x, y] = scale_point(first.x, first.y);
-        auto now = std::chrono::steady_clock::now();
-        if (!shell_handler_->write(MAA_FMT::format("d {} {} {} {}\nc\n", 0, x, y, press_))) {
-            return false;
-        }
-        auto used = std::chrono::steady_clock::now() - now;
-        auto expect = std::chrono::milliseconds(first.delay);
-        if (used < expect) {
-            std::this_thread::sleep_for(expect - used);
+    // 整段手势连同 w 等待一次写进去，由设备端按节奏执行，不再在这边逐步 sleep
+    std::string gesture;
+    int total_delay = 0;
+    for (auto it = steps.begin(); it != steps.end(); ++it) {
+        auto [x, y] = scale_point(it->x, it->y);
+        gesture += MAA_FMT::format("{} {} {} {} {}\nc\n", it == steps.begin() ? 'd' : 'm', 0, x, y, press_);
+        if (it->delay > 0) {
+            gesture += MAA_FMT::format("w {}\n", it->delay);
+            total_delay += it->delay;
         }
     }
+    gesture += MAA_FMT::format("u {}\nc\n", 0);
 
-    for (auto it = steps.begin() + 1; it != steps.end(); it++) {
-        int x = it->x, y = it->y;
-        auto now = std::chrono::steady_clock::now();
-        auto res = shell_handler_->write(MAA_FMT::format("m {} {} {} {}\nc\n", 0, x, y, press_));
-        if (!res) {
-            return false;
-        }
-        auto used = std::chrono::steady_clock::now() - now;
-        auto expect = std::chrono::milliseconds(it->delay);
-        if (used < expect) {
-            std::this_thread::sleep_for(expect - used);
-        }
+    if (!shell_handler_->write(gesture)) {
+        LogError << "swipe failed";
+        return false;
     }
 
-    return shell_handler_->write(MAA_FMT::format("u {}\nc\n", 0));
+    // 设备端按顺序执行，前一段没做完的话这段要排在它后面
+    auto gesture_start = std::max(gesture_end_.load(), std::chrono::steady_clock::now());
+    gesture_end_ = gesture_start + std::chrono::milliseconds(total_delay);
+    return true;
 }
 
 std::pair<int, int> MinitouchInput::scale_point(int x, int y)
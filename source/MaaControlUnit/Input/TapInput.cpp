@@ -30,7 +30,7 @@ bool TapTouchInput::click(int x, int y)
     merge_replacement({ { "{X}", std::to_string(x) }, { "{Y}", std::to_string(y) } });
 
     LogDebug << VAR(x) << VAR(y);
-    auto cmd_ret = command(click_argv_.gen(argv_replace_));
+    auto cmd_ret = shell_session_->exec(click_argv_.gen(argv_replace_));
 
     return cmd_ret && cmd_ret->empty();
 }
@@ -54,7 +54,7 @@ bool TapTouchInput::swipe(const std::vector<SwipeStep>& steps)
                         { "{X2}", std::to_string(steps.back().x) },
                         { "{Y2}", std::to_string(steps.back().y) },
                         { "{DURATION}", std::to_string(delay_sum) } });
-    auto cmd_ret = command(swipe_argv_.gen(argv_replace_));
+    auto cmd_ret = shell_session_->exec(swipe_argv_.gen(argv_replace_));
 
     return cmd_ret.has_value() && cmd_ret.value().empty();
 }
@@ -69,7 +69,7 @@ bool TapKeyInput::press_key(int key)
     LogFunc;
 
     merge_replacement({ { "{KEY}", std::to_string(key) } });
-    auto cmd_ret = command(press_key_argv_.gen(argv_replace_));
+    auto cmd_ret = shell_session_->exec(press_key_argv_.gen(argv_replace_));
 
     return cmd_ret.has_value() && cmd_ret.value().empty();
 }
@@ -2,11 +2,14 @@
 
 #include "UnitBase.h"
 
+#include "General/ShellSession.h"
+
 MAA_CTRL_UNIT_NS_BEGIN
 
 class TapTouchInput : public TouchInputBase
 {
 public:
+    TapTouchInput() { children_.emplace_back(shell_session_); }
     virtual ~TapTouchInput() override = default;
 
 public: // from UnitBase
@@ -23,11 +26,14 @@ public: // from TouchInputAPI
 private:
     Argv click_argv_;
     Argv swipe_argv_;
+
+    std::shared_ptr<ShellSession> shell_session_ = std::make_shared<ShellSession>();
 };
 
 class TapKeyInput : public KeyInputBase
 {
 public:
+    TapKeyInput() { children_.emplace_back(shell_session_); }
     virtual ~TapKeyInput() override = default;
 
 public: // from UnitBase
@@ -38,6 +44,8 @@ public: // from KeyInputAPI
 
 private:
     Argv press_key_argv_;
+
+    std::shared_ptr<ShellSession> shell_session_ = std::make_shared<ShellSession>();
 };
 
 MAA_CTRL_UNIT_NS_END
@@ -0,0 +1,860 @@
+#include "AdbWireIO.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <utility>
+
+#include "Utils/Format.hpp"
+#include "Utils/Logger.h"
+#include "Utils/Platform.h"
+#include "Utils/Ranges.hpp"
+
+MAA_CTRL_UNIT_NS_BEGIN
+
+using namespace std::chrono_literals;
+
+// 池里每个设备最多留几条空闲连接
+static constexpr size_t kPoolSize = 2;
+static constexpr auto kPoolTimeout = 3s;
+// call_command 的 timeout 为 0 时不限时
+static constexpr auto kNoTimeout = 24h;
+static constexpr size_t kSyncMaxData = 64 * 1024;
+
+enum ShellPacketId : char
+{
+    kShellStdin = 0,
+    kShellStdout = 1,
+    kShellStderr = 2,
+    kShellExit = 3,
+};
+
+static std::string le32(uint32_t value)
+{
+    std::string result(4, '\0');
+    for (size_t i = 0; i != 4; ++i) {
+        result[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+    return result;
+}
+
+static uint32_t from_le32(std::string_view data)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i != 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+static std::string shell_packet(ShellPacketId id, std::string_view data)
+{
+    return static_cast<char>(id) + le32(static_cast<uint32_t>(data.size())) + std::string(data);
+}
+
+// 从缓冲区头部取出一个完整的 shell v2 包
+static std::optional<std::pair<char, std::string>> take_shell_packet(std::string& raw)
+{
+    constexpr size_t kHeaderSize = 5;
+    if (raw.size() < kHeaderSize) {
+        return std::nullopt;
+    }
+    size_t len = from_le32(std::string_view(raw).substr(1, 4));
+    if (raw.size() < kHeaderSize + len) {
+        return std::nullopt;
+    }
+    std::pair<char, std::string> packet { raw.front(), raw.substr(kHeaderSize, len) };
+    raw.erase(0, kHeaderSize + len);
+    return packet;
+}
+
+static std::string sync_packet(std::string_view id, std::string_view data)
+{
+    return std::string(id) + le32(static_cast<uint32_t>(data.size())) + std::string(data);
+}
+
+static std::string join_args(const std::vector<std::string>& args)
+{
+    std::string result;
+    for (const auto& arg : args) {
+        if (!result.empty()) {
+            result += ' ';
+        }
+        result += arg;
+    }
+    return result;
+}
+
+template <typename AsyncOp>
+boost::system::error_code AdbWireConnection::run(AsyncOp&& op, Deadline deadline, size_t& transferred)
+{
+    boost::system::error_code ec = boost::asio::error::would_block;
+    op([&](const boost::system::error_code& e, size_t n) {
+        ec = e;
+        transferred = n;
+    });
+
+    ios_.restart();
+    ios_.run_until(deadline);
+    if (ec == boost::asio::error::would_block) {
+        // 超时：取消还没完成的操作，等回调跑完再返回
+        boost::system::error_code ignored;
+        sock_.cancel(ignored);
+        ios_.restart();
+        ios_.run();
+        if (ec == boost::asio::error::operation_aborted) {
+            ec = boost::asio::error::timed_out;
+        }
+    }
+    return ec;
+}
+
+bool AdbWireConnection::connect(const std::string& host, unsigned short port, Deadline deadline)
+{
+    boost::system::error_code addr_ec;
+    auto address = boost::asio::ip::make_address(host, addr_ec);
+    if (addr_ec) {
+        return false;
+    }
+    boost::asio::ip::tcp::endpoint endpoint(address, port);
+
+    size_t transferred = 0;
+    auto ec = run(
+        [&](auto&& handler) {
+            sock_.async_connect(endpoint, [handler](const boost::system::error_code& e) { handler(e, 0); });
+        },
+        deadline, transferred);
+    if (ec) {
+        close();
+        return false;
+    }
+
+    boost::system::error_code ignored;
+    sock_.set_option(boost::asio::ip::tcp::no_delay(true), ignored);
+    return true;
+}
+
+void AdbWireConnection::close() noexcept
+{
+    boost::system::error_code ignored;
+    sock_.close(ignored);
+}
+
+bool AdbWireConnection::request(std::string_view service, Deadline deadline)
+{
+    return write(MAA_FMT::format("{:04x}", service.size()) + std::string(service), deadline) && read_status(deadline);
+}
+
+bool AdbWireConnection::read_status(Deadline deadline)
+{
+    fail_message_.clear();
+
+    auto status = read_exact(4, deadline);
+    if (!status) {
+        return false;
+    }
+    if (*status == "OKAY") {
+        return true;
+    }
+    if (*status == "FAIL") {
+        fail_message_ = read_hex_string(deadline).value_or("");
+    }
+    else {
+        fail_message_ = "unexpected status: " + *status;
+    }
+    return false;
+}
+
+std::optional<std::string> AdbWireConnection::read_hex_string(Deadline deadline)
+{
+    auto len_str = read_exact(4, deadline);
+    if (!len_str) {
+        return std::nullopt;
+    }
+
+    size_t len = 0;
+    try {
+        len = std::stoul(*len_str, nullptr, 16);
+    }
+    catch (const std::exception&) {
+        return std::nullopt;
+    }
+    return read_exact(len, deadline);
+}
+
+bool AdbWireConnection::write(std::string_view data, Deadline deadline)
+{
+    size_t transferred = 0;
+    auto ec = run(
+        [&](auto&& handler) { boost::asio::async_write(sock_, boost::asio::buffer(data), handler); }, deadline,
+        transferred);
+    if (ec) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+std::optional<std::string> AdbWireConnection::read_exact(size_t size, Deadline deadline)
+{
+    std::string result(size, '\0');
+    if (size == 0) {
+        return result;
+    }
+
+    size_t transferred = 0;
+    auto ec = run(
+        [&](auto&& handler) { boost::asio::async_read(sock_, boost::asio::buffer(result), handler); }, deadline,
+        transferred);
+    if (ec) {
+        // 读了一半的话流已经错位了，不能再用
+        close();
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<std::string> AdbWireConnection::read_some(Deadline deadline)
+{
+    single_page_buffer<char> buffer;
+
+    size_t transferred = 0;
+    auto ec = run(
+        [&](auto&& handler) {
+            sock_.async_read_some(boost::asio::mutable_buffer(buffer.get(), buffer.size()), handler);
+        },
+        deadline, transferred);
+    if (ec == boost::asio::error::timed_out) {
+        return std::string();
+    }
+    if (ec) {
+        close();
+        return std::nullopt;
+    }
+    return std::string(buffer.get(), transferred);
+}
+
+AdbWireIO::AdbWireIO(std::shared_ptr<PlatformIO> fallback, std::string adb_path, std::string server_host,
+                     unsigned short server_port)
+    : fallback_(std::move(fallback)), adb_path_(std::move(adb_path)), server_host_(std::move(server_host)),
+      server_port_(server_port)
+{
+    support_socket_ = fallback_->support_socket_;
+    refill_thread_ = std::thread(&AdbWireIO::refilling, this);
+}
+
+AdbWireIO::~AdbWireIO()
+{
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex_);
+        pool_exit_ = true;
+    }
+    pool_cond_.notify_all();
+    if (refill_thread_.joinable()) {
+        refill_thread_.join();
+    }
+}
+
+int AdbWireIO::call_command(const std::vector<std::string>& cmd, bool recv_by_socket, std::string& pipe_data,
+                            std::string& sock_data, int64_t timeout)
+{
+    auto adb_cmd = recv_by_socket ? std::nullopt : parse_command(cmd);
+    if (!adb_cmd) {
+        return fallback_->call_command(cmd, recv_by_socket, pipe_data, sock_data, timeout);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() +
+                    (timeout ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                   std::chrono::milliseconds(timeout))
+                             : std::chrono::duration_cast<std::chrono::steady_clock::duration>(kNoTimeout));
+
+    std::optional<int> ret;
+    const auto& verb = adb_cmd->verb;
+    if (verb == "shell") {
+        ret = shell(*adb_cmd, pipe_data, deadline);
+    }
+    else if (verb == "exec-out") {
+        ret = exec_out(*adb_cmd, pipe_data, deadline);
+    }
+    else if (verb == "forward") {
+        ret = forward(*adb_cmd, pipe_data, deadline);
+    }
+    else if (verb == "connect") {
+        ret = connect(*adb_cmd, pipe_data, deadline);
+    }
+    else if (verb == "push") {
+        ret = push(*adb_cmd, pipe_data, deadline);
+    }
+    else if (verb == "pull") {
+        ret = pull(*adb_cmd, pipe_data, deadline);
+    }
+
+    if (!ret) {
+        LogDebug << "adb wire protocol unavailable, fallback" << VAR(cmd);
+        pipe_data.clear();
+        return fallback_->call_command(cmd, recv_by_socket, pipe_data, sock_data, timeout);
+    }
+    return *ret;
+}
+
+std::optional<unsigned short> AdbWireIO::create_socket(const std::string& local_address)
+{
+    return fallback_->create_socket(local_address);
+}
+
+void AdbWireIO::close_socket() noexcept
+{
+    fallback_->close_socket();
+}
+
+std::shared_ptr<IOHandler> AdbWireIO::tcp(const std::string& target, unsigned short port)
+{
+    return fallback_->tcp(target, port);
+}
+
+std::shared_ptr<IOHandler> AdbWireIO::interactive_shell(const std::vector<std::string>& cmd)
+{
+    auto adb_cmd = parse_command(cmd);
+    if (!adb_cmd || adb_cmd->verb != "shell") {
+        return fallback_->interactive_shell(cmd);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + kPoolTimeout;
+    // 老设备没有 shell v2，stdin 没法和 stdout 分开，交给 adb 进程
+    if (!support_shell_v2(adb_cmd->serial, deadline).value_or(false)) {
+        return fallback_->interactive_shell(cmd);
+    }
+
+    bool refused = false;
+    auto conn = open_service(adb_cmd->serial, "shell,v2,raw:" + join_args(adb_cmd->args), deadline, refused);
+    if (!conn) {
+        return fallback_->interactive_shell(cmd);
+    }
+    return std::make_shared<IOHandlerAdbShell>(std::move(conn));
+}
+
+bool AdbWireIO::is_adb(const std::string& adb_path)
+{
+    auto stem = path_to_utf8_string(path(adb_path).stem());
+    MAA_RNS::ranges::transform(stem, stem.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+    return stem == "adb";
+}
+
+std::optional<std::pair<std::string, unsigned short>> AdbWireIO::server_from_env()
+{
+    auto env = boost::this_process::environment();
+    auto get = [&](const std::string& key) -> std::string {
+        auto iter = env.find(key);
+        return iter == env.end() ? std::string() : iter->to_string();
+    };
+
+    // tcp:host:port、localfilesystem: 等写法太多，交给 adb 进程自己处理
+    if (!get("ADB_SERVER_SOCKET").empty()) {
+        return std::nullopt;
+    }
+
+    std::string host = get("ANDROID_ADB_SERVER_ADDRESS");
+    if (host.empty() || host == "localhost") {
+        host = "127.0.0.1";
+    }
+    boost::system::error_code ec;
+    boost::asio::ip::make_address(host, ec);
+    if (ec) {
+        LogWarn << "adb server address is not an ip, skip adb wire protocol" << VAR(host);
+        return std::nullopt;
+    }
+
+    unsigned short port = 5037;
+    if (auto port_str = get("ANDROID_ADB_SERVER_PORT"); !port_str.empty()) {
+        try {
+            int value = std::stoi(port_str);
+            if (value <= 0 || value > 65535) {
+                throw std::out_of_range(port_str);
+            }
+            port = static_cast<unsigned short>(value);
+        }
+        catch (const std::exception&) {
+            LogWarn << "invalid ANDROID_ADB_SERVER_PORT, skip adb wire protocol" << VAR(port_str);
+            return std::nullopt;
+        }
+    }
+    return std::make_pair(std::move(host), port);
+}
+
+std::optional<AdbWireIO::AdbCommand> AdbWireIO::parse_command(const std::vector<std::string>& cmd) const
+{
+    // 只接管配置的 adb 本身，controller_config 里换成别的程序的命令照常起进程
+    if (cmd.empty() || cmd.front() != adb_path_) {
+        return std::nullopt;
+    }
+
+    AdbCommand result;
+
+    size_t i = 1;
+    for (; i + 1 < cmd.size() && cmd[i].starts_with('-'); i += 2) {
+        const auto& option = cmd[i];
+        const auto& value = cmd[i + 1];
+        if (option == "-s") {
+            result.serial = value;
+        }
+        // 指向别的 server 的命令交给 adb 进程
+        else if (option == "-H") {
+            if (value != server_host_ && !(value == "localhost" && server_host_ == "127.0.0.1")) {
+                return std::nullopt;
+            }
+        }
+        else if (option == "-P") {
+            if (value != std::to_string(server_port_)) {
+                return std::nullopt;
+            }
+        }
+        // 其他全局参数（-t、-d、-e ...）原样交给 adb 进程
+        else {
+            return std::nullopt;
+        }
+    }
+    if (i >= cmd.size() || cmd[i].starts_with('-')) {
+        return std::nullopt;
+    }
+
+    result.verb = cmd[i];
+    result.args.assign(cmd.begin() + i + 1, cmd.end());
+    return result;
+}
+
+std::optional<int> AdbWireIO::shell(const AdbCommand& cmd, std::string& output, Deadline deadline)
+{
+    auto v2 = support_shell_v2(cmd.serial, deadline);
+    if (!v2) {
+        return std::nullopt;
+    }
+    if (!*v2) {
+        // 老协议拿不到退出码，交给 adb 进程
+        return std::nullopt;
+    }
+
+    bool refused = false;
+    auto conn = open_service(cmd.serial, "shell,v2,raw:" + join_args(cmd.args), deadline, refused);
+    if (!conn) {
+        return refused ? std::make_optional(1) : std::nullopt;
+    }
+
+    std::string raw;
+    while (true) {
+        auto packet = take_shell_packet(raw);
+        if (!packet) {
+            auto data = conn->read_some(deadline);
+            if (!data || data->empty()) {
+                LogError << "shell interrupted" << VAR(cmd.serial) << VAR(cmd.args) << VAR(data.has_value());
+                return -1;
+            }
+            raw += *data;
+            continue;
+        }
+
+        switch (packet->first) {
+        case kShellStdout:
+            output += packet->second;
+            break;
+        case kShellExit:
+            return packet->second.empty() ? 0 : static_cast<unsigned char>(packet->second.front());
+        default:
+            break;
+        }
+    }
+}
+
+std::optional<int> AdbWireIO::exec_out(const AdbCommand& cmd, std::string& output, Deadline deadline)
+{
+    bool refused = false;
+    auto conn = open_service(cmd.serial, "exec:" + join_args(cmd.args), deadline, refused);
+    if (!conn) {
+        return refused ? std::make_optional(1) : std::nullopt;
+    }
+
+    while (true) {
+        auto data = conn->read_some(deadline);
+        if (!data) {
+            // 对端关闭即输出结束
+            return 0;
+        }
+        if (data->empty()) {
+            LogError << "exec timeout" << VAR(cmd.serial) << VAR(cmd.args);
+            return -1;
+        }
+        output += *data;
+    }
+}
+
+std::optional<int> AdbWireIO::forward(const AdbCommand& cmd, std::string& output, Deadline deadline)
+{
+    if (cmd.args.size() != 2) {
+        return std::nullopt;
+    }
+
+    auto conn = connect_server(deadline);
+    if (!conn) {
+        return std::nullopt;
+    }
+
+    std::string prefix = cmd.serial.empty() ? "host" : "host-serial:" + cmd.serial;
+    if (!conn->request(MAA_FMT::format("{}:forward:{};{}", prefix, cmd.args[0], cmd.args[1]), deadline)) {
+        if (conn->fail_message().empty()) {
+            return std::nullopt;
+        }
+        LogError << "forward failed" << VAR(cmd.args) << VAR(conn->fail_message());
+        return 1;
+    }
+    // server 先确认收到请求，forward 建好后再回一次
+    if (!conn->read_status(deadline)) {
+        LogError << "forward failed" << VAR(cmd.args) << VAR(conn->fail_message());
+        return 1;
+    }
+    if (cmd.args[0] == "tcp:0") {
+        output = conn->read_hex_string(deadline).value_or("") + "\n";
+    }
+    return 0;
+}
+
+std::optional<int> AdbWireIO::connect(const AdbCommand& cmd, std::string& output, Deadline deadline)
+{
+    if (cmd.args.size() != 1) {
+        return std::nullopt;
+    }
+
+    // server 没起来时交给 adb 进程，它会顺便把 server 拉起来
+    auto conn = connect_server(deadline);
+    if (!conn) {
+        return std::nullopt;
+    }
+
+    if (!conn->request("host:connect:" + cmd.args.front(), deadline)) {
+        if (conn->fail_message().empty()) {
+            return std::nullopt;
+        }
+        output = "error: " + conn->fail_message() + "\n";
+        return 1;
+    }
+
+    auto message = conn->read_hex_string(deadline);
+    if (!message) {
+        return 1;
+    }
+    output = *message + "\n";
+
+    {
+        std::unique_lock<std::mutex> lock(features_mutex_);
+        shell_v2_.erase(cmd.args.front());
+    }
+    return message->starts_with("failed") || message->find("cannot") != std::string::npos ? 1 : 0;
+}
+
+std::optional<int> AdbWireIO::push(const AdbCommand& cmd, std::string& output, Deadline deadline)
+{
+    if (cmd.args.size() != 2) {
+        return std::nullopt;
+    }
+    const auto& local = path(cmd.args[0]);
+    const auto& remote = cmd.args[1];
+
+    std::ifstream ifs(local, std::ios::in | std::ios::binary);
+    if (!ifs.is_open()) {
+        output = "error: cannot open " + cmd.args[0] + "\n";
+        return 1;
+    }
+
+    std::error_code ec;
+    auto perms = static_cast<uint32_t>(std::filesystem::status(local, ec).permissions()) & 0777;
+    // S_IFREG
+    uint32_t mode = 0100000 | (perms ? perms : 0644);
+
+    bool refused = false;
+    auto conn = open_service(cmd.serial, "sync:", deadline, refused);
+    if (!conn) {
+        return refused ? std::make_optional(1) : std::nullopt;
+    }
+
+    if (!conn->write(sync_packet("SEND", MAA_FMT::format("{},{}", remote, mode)), deadline)) {
+        return -1;
+    }
+
+    std::string buffer(kSyncMaxData, '\0');
+    while (ifs) {
+        ifs.read(buffer.data(), buffer.size());
+        auto read_num = static_cast<size_t>(ifs.gcount());
+        if (read_num == 0) {
+            break;
+        }
+        if (!conn->write(sync_packet("DATA", std::string_view(buffer.data(), read_num)), deadline)) {
+            return -1;
+        }
+    }
+
+    auto mtime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+    if (!conn->write("DONE" + le32(static_cast<uint32_t>(mtime.count())), deadline)) {
+        return -1;
+    }
+
+    auto status = conn->read_exact(8, deadline);
+    if (!status) {
+        return -1;
+    }
+    if (status->starts_with("FAIL")) {
+        output = "error: " + conn->read_exact(from_le32(std::string_view(*status).substr(4)), deadline).value_or("") +
+                 "\n";
+        return 1;
+    }
+
+    conn->write(sync_packet("QUIT", ""), deadline);
+    return status->starts_with("OKAY") ? 0 : 1;
+}
+
+std::optional<int> AdbWireIO::pull(const AdbCommand& cmd, std::string& output, Deadline deadline)
+{
+    if (cmd.args.size() != 2) {
+        return std::nullopt;
+    }
+    const auto& remote = cmd.args[0];
+    const auto& local = path(cmd.args[1]);
+
+    bool refused = false;
+    auto conn = open_service(cmd.serial, "sync:", deadline, refused);
+    if (!conn) {
+        return refused ? std::make_optional(1) : std::nullopt;
+    }
+
+    if (!conn->write(sync_packet("RECV", remote), deadline)) {
+        return -1;
+    }
+
+    std::ofstream ofs(local, std::ios::out | std::ios::binary);
+    if (!ofs.is_open()) {
+        output = "error: cannot open " + cmd.args[1] + "\n";
+        return 1;
+    }
+
+    while (true) {
+        auto header = conn->read_exact(8, deadline);
+        if (!header) {
+            return -1;
+        }
+        auto id = std::string_view(*header).substr(0, 4);
+        auto len = from_le32(std::string_view(*header).substr(4));
+
+        if (id == "DONE") {
+            break;
+        }
+        auto data = conn->read_exact(len, deadline);
+        if (!data) {
+            return -1;
+        }
+        if (id == "FAIL") {
+            output = "error: " + *data + "\n";
+            return 1;
+        }
+        if (id != "DATA") {
+            LogError << "unexpected sync packet" << VAR(id);
+            return -1;
+        }
+        ofs.write(data->data(), data->size());
+    }
+
+    conn->write(sync_packet("QUIT", ""), deadline);
+    return 0;
+}
+
+std::unique_ptr<AdbWireConnection> AdbWireIO::connect_server(Deadline deadline)
+{
+    auto conn = std::make_unique<AdbWireConnection>();
+    if (!conn->connect(server_host_, server_port_, deadline)) {
+        return nullptr;
+    }
+    return conn;
+}
+
+std::unique_ptr<AdbWireConnection> AdbWireIO::open_transport(const std::string& serial, Deadline deadline)
+{
+    auto conn = connect_server(deadline);
+    if (!conn) {
+        return nullptr;
+    }
+    if (!conn->request(serial.empty() ? "host:transport-any" : "host:transport:" + serial, deadline)) {
+        LogDebug << "transport failed" << VAR(serial) << VAR(conn->fail_message());
+        return nullptr;
+    }
+    return conn;
+}
+
+std::unique_ptr<AdbWireConnection> AdbWireIO::open_service(const std::string& serial, const std::string& service,
+                                                           Deadline deadline, bool& refused)
+{
+    refused = false;
+
+    std::unique_ptr<AdbWireConnection> pooled;
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex_);
+        auto& idle = pool_[serial];
+        if (!idle.empty()) {
+            pooled = std::move(idle.back());
+            idle.pop_back();
+        }
+    }
+    request_refill(serial);
+
+    if (pooled && pooled->request(service, deadline)) {
+        return pooled;
+    }
+    if (pooled && !pooled->fail_message().empty()) {
+        // 连接是好的，是设备拒绝了这个请求
+        LogError << "service refused" << VAR(serial) << VAR(service) << VAR(pooled->fail_message());
+        refused = true;
+        return nullptr;
+    }
+
+    auto conn = open_transport(serial, deadline);
+    if (!conn) {
+        return nullptr;
+    }
+    if (!conn->request(service, deadline)) {
+        LogError << "service refused" << VAR(serial) << VAR(service) << VAR(conn->fail_message());
+        refused = !conn->fail_message().empty();
+        return nullptr;
+    }
+    return conn;
+}
+
+std::optional<bool> AdbWireIO::support_shell_v2(const std::string& serial, Deadline deadline)
+{
+    {
+        std::unique_lock<std::mutex> lock(features_mutex_);
+        if (auto it = shell_v2_.find(serial); it != shell_v2_.end()) {
+            return it->second;
+        }
+    }
+
+    auto conn = connect_server(deadline);
+    if (!conn) {
+        return std::nullopt;
+    }
+    if (!conn->request(serial.empty() ? "host:features" : "host-serial:" + serial + ":features", deadline)) {
+        return std::nullopt;
+    }
+    auto features = conn->read_hex_string(deadline);
+    if (!features) {
+        return std::nullopt;
+    }
+
+    bool v2 = false;
+    std::string_view rest = *features;
+    while (!rest.empty()) {
+        auto pos = rest.find(',');
+        if (rest.substr(0, pos) == "shell_v2") {
+            v2 = true;
+            break;
+        }
+        rest = pos == std::string_view::npos ? std::string_view() : rest.substr(pos + 1);
+    }
+    LogInfo << VAR(serial) << VAR(v2);
+
+    std::unique_lock<std::mutex> lock(features_mutex_);
+    shell_v2_.insert_or_assign(serial, v2);
+    return v2;
+}
+
+void AdbWireIO::request_refill(const std::string& serial)
+{
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex_);
+        if (std::find(refill_queue_.begin(), refill_queue_.end(), serial) != refill_queue_.end()) {
+            return;
+        }
+        refill_queue_.emplace_back(serial);
+    }
+    pool_cond_.notify_one();
+}
+
+void AdbWireIO::refilling()
+{
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+
+    while (true) {
+        pool_cond_.wait(lock, [&]() { return pool_exit_ || !refill_queue_.empty(); });
+        if (pool_exit_) {
+            return;
+        }
+
+        std::string serial = refill_queue_.front();
+        if (pool_[serial].size() >= kPoolSize) {
+            refill_queue_.pop_front();
+            continue;
+        }
+
+        lock.unlock();
+        auto conn = open_transport(serial, std::chrono::steady_clock::now() + kPoolTimeout);
+        lock.lock();
+
+        if (!conn) {
+            // 设备不在或者 server 没起来，等下次用到时再补
+            refill_queue_.pop_front();
+            continue;
+        }
+        pool_[serial].emplace_back(std::move(conn));
+    }
+}
+
+bool IOHandlerAdbShell::write(std::string_view data)
+{
+    if (closed_) {
+        return false;
+    }
+    return conn_->write(shell_packet(kShellStdin, data), std::chrono::steady_clock::now() + kPoolTimeout);
+}
+
+std::string IOHandlerAdbShell::read(unsigned timeout_sec)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout_sec * 1s;
+    while (stdout_.empty() && receive(deadline)) {
+    }
+
+    return std::exchange(stdout_, std::string());
+}
+
+std::string IOHandlerAdbShell::read(unsigned timeout_sec, size_t expect)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout_sec * 1s;
+    while (stdout_.size() < expect && receive(deadline)) {
+    }
+
+    std::string result = stdout_.substr(0, expect);
+    stdout_.erase(0, result.size());
+    return result;
+}
+
+bool IOHandlerAdbShell::receive(AdbWireConnection::Deadline deadline)
+{
+    if (closed_) {
+        return false;
+    }
+
+    auto data = conn_->read_some(deadline);
+    if (!data) {
+        closed_ = true;
+        return false;
+    }
+    if (data->empty()) {
+        return false;
+    }
+    raw_ += *data;
+
+    while (auto packet = take_shell_packet(raw_)) {
+        if (packet->first == kShellStdout) {
+            stdout_ += packet->second;
+        }
+        else if (packet->first == kShellExit) {
+            closed_ = true;
+        }
+    }
+    return true;
+}
+
+MAA_CTRL_UNIT_NS_END
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "PlatformIO.h"
+#include "Utils/Boost.hpp"
+#include "Utils/NonCopyable.hpp"
+
+MAA_CTRL_UNIT_NS_BEGIN
+
+// 与 adb server 之间的一条 smart socket 连接，每条连接有自己的 io_context，所有读写都带截止时间
+class AdbWireConnection : public NonCopyable
+{
+public:
+    using Deadline = std::chrono::steady_clock::time_point;
+
+    AdbWireConnection() : sock_(ios_) {}
+    ~AdbWireConnection() { close(); }
+
+    bool connect(const std::string& host, unsigned short port, Deadline deadline);
+    void close() noexcept;
+
+    // 发送带 4 位十六进制长度前缀的请求，并读取 OKAY / FAIL
+    bool request(std::string_view service, Deadline deadline);
+    bool read_status(Deadline deadline);
+    std::optional<std::string> read_hex_string(Deadline deadline);
+
+    bool write(std::string_view data, Deadline deadline);
+    std::optional<std::string> read_exact(size_t size, Deadline deadline);
+    // 超时返回空串，连接断开返回 nullopt
+    std::optional<std::string> read_some(Deadline deadline);
+
+    const std::string& fail_message() const { return fail_message_; }
+
+private:
+    template <typename AsyncOp>
+    boost::system::error_code run(AsyncOp&& op, Deadline deadline, size_t& transferred);
+
+    boost::asio::io_context ios_;
+    boost::asio::ip::tcp::socket sock_;
+    std::string fail_message_;
+};
+
+// 直接走 adb server 的协议（host:transport、shell、exec、sync）执行 adb 命令，省掉每条命令拉起一个 adb 进程的开销。
+// 只接管 argv[0] 为 adb_path 的命令；已切换到设备 transport 的空闲连接会被池化复用；
+// 认不出的命令、拿不到退出码、连不上 server 时都交给 fallback
+class AdbWireIO : public PlatformIO
+{
+public:
+    AdbWireIO(std::shared_ptr<PlatformIO> fallback, std::string adb_path, std::string server_host,
+              unsigned short server_port);
+    virtual ~AdbWireIO() override;
+
+    // 可执行文件名是不是 adb，包装脚本等其他程序不走 server 协议
+    static bool is_adb(const std::string& adb_path);
+    // 和 adb 一样读 ANDROID_ADB_SERVER_ADDRESS / ANDROID_ADB_SERVER_PORT；
+    // 设置了 ADB_SERVER_SOCKET 或值不合法时返回 nullopt
+    static std::optional<std::pair<std::string, unsigned short>> server_from_env();
+
+    int call_command(const std::vector<std::string>& cmd, bool recv_by_socket, std::string& pipe_data,
+                     std::string& sock_data, int64_t timeout) override;
+
+    std::optional<unsigned short> create_socket(const std::string& local_address) override;
+    void close_socket() noexcept override;
+
+    std::shared_ptr<IOHandler> tcp(const std::string& target, unsigned short port) override;
+    std::shared_ptr<IOHandler> interactive_shell(const std::vector<std::string>& cmd) override;
+
+private:
+    using Deadline = AdbWireConnection::Deadline;
+
+    struct AdbCommand
+    {
+        std::string serial;
+        std::string verb;
+        std::vector<std::string> args;
+    };
+    std::optional<AdbCommand> parse_command(const std::vector<std::string>& cmd) const;
+
+    // 返回 nullopt 表示请求还没被 server 接受，可以安全地交给 fallback 重来
+    std::optional<int> shell(const AdbCommand& cmd, std::string& output, Deadline deadline);
+    std::optional<int> exec_out(const AdbCommand& cmd, std::string& output, Deadline deadline);
+    std::optional<int> forward(const AdbCommand& cmd, std::string& output, Deadline deadline);
+    std::optional<int> connect(const AdbCommand& cmd, std::string& output, Deadline deadline);
+    std::optional<int> push(const AdbCommand& cmd, std::string& output, Deadline deadline);
+    std::optional<int> pull(const AdbCommand& cmd, std::string& output, Deadline deadline);
+
+    std::unique_ptr<AdbWireConnection> connect_server(Deadline deadline);
+    std::unique_ptr<AdbWireConnection> open_transport(const std::string& serial, Deadline deadline);
+    // 取一条已在 transport 上的连接并请求 service；池里的连接可能已失效，失败时换新连接再试一次
+    std::unique_ptr<AdbWireConnection> open_service(const std::string& serial, const std::string& service,
+                                                    Deadline deadline, bool& refused);
+    std::optional<bool> support_shell_v2(const std::string& serial, Deadline deadline);
+
+    void request_refill(const std::string& serial);
+    void refilling();
+
+    std::shared_ptr<PlatformIO> fallback_;
+    const std::string adb_path_;
+    const std::string server_host_;
+    const unsigned short server_port_ = 0;
+
+    std::mutex features_mutex_;
+    std::map<std::string, bool> shell_v2_;
+
+    std::mutex pool_mutex_;
+    std::condition_variable pool_cond_;
+    std::map<std::string, std::vector<std::unique_ptr<AdbWireConnection>>> pool_;
+    std::deque<std::string> refill_queue_;
+    bool pool_exit_ = false;
+    std::thread refill_thread_;
+};
+
+// shell v2 协议的交互式 shell：stdin 按包写入，stdout 按包拆出
+class IOHandlerAdbShell : public IOHandler, NonCopyable
+{
+public:
+    explicit IOHandlerAdbShell(std::unique_ptr<AdbWireConnection> conn) : conn_(std::move(conn)) {}
+    virtual ~IOHandlerAdbShell() override = default;
+
+    virtual bool write(std::string_view data) override;
+    virtual std::string read(unsigned timeout_sec) override;
+    virtual std::string read(unsigned timeout_sec, size_t expect) override;
+    virtual bool eof() const override { return closed_ && stdout_.empty(); }
+
+private:
+    bool receive(AdbWireConnection::Deadline deadline);
+
+    std::unique_ptr<AdbWireConnection> conn_;
+    std::string raw_;
+    std::string stdout_;
+    bool closed_ = false;
+};
+
+MAA_CTRL_UNIT_NS_END
@@ -149,12 +149,14 @@ std::string IOHandlerBoostSocket::read(unsigned timeout_sec)
     std::string result;
 
     boost::system::error_code error;
-    while (check_timeout(start_time) && sock_.is_open()) {
+    while (check_timeout(start_time) && sock_.is_open() && !eof_) {
         auto read_num = sock_.read_some(boost::asio::mutable_buffer(buffer, bufferSize), error);
-        while (error != boost::asio::error::eof && read_num > 0) {
+        while (!error && read_num > 0) {
             result.insert(result.end(), buffer, buffer + read_num);
             read_num = sock_.read_some(boost::asio::mutable_buffer(buffer, bufferSize), error);
         }
+        // eof 或连接被重置，都不会再有数据了
+        eof_ = static_cast<bool>(error);
         break;
     }
 
@@ -175,14 +177,16 @@ std::string IOHandlerBoostSocket::read(unsigned timeout_sec, size_t expect)
     std::string result;
 
     boost::system::error_code error;
-    while (expect > result.size() && sock_.is_open() && check_timeout(start_time)) {
+    while (expect > result.size() && sock_.is_open() && !eof_ && check_timeout(start_time)) {
         auto maxi = std::min(bufferSize, expect - result.size());
         auto read_num = sock_.read_some(boost::asio::mutable_buffer(buffer, maxi), error);
-        while (error != boost::asio::error::eof && read_num > 0) {
+        while (!error && read_num > 0) {
             result.insert(result.end(), buffer, buffer + read_num);
             maxi = std::min(bufferSize, expect - result.size());
             read_num = sock_.read_some(boost::asio::mutable_buffer(buffer, maxi), error);
         }
+        // eof 或连接被重置，都不会再有数据了，不用空转到超时
+        eof_ = static_cast<bool>(error);
     }
 
     return result;
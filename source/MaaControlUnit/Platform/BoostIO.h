@@ -39,10 +39,12 @@ public:
     virtual bool write(std::string_view data) override;
     virtual std::string read(unsigned timeout_sec) override;
     virtual std::string read(unsigned timeout_sec, size_t expect) override;
+    virtual bool eof() const override { return eof_ || !sock_.is_open(); }
 
 private:
     std::shared_ptr<boost::asio::io_context> ios_;
     boost::asio::ip::tcp::socket sock_;
+    bool eof_ = false;
 };
 
 class IOHandlerBoostStream : public IOHandler, NonCopyable
@@ -58,6 +60,7 @@ public:
     virtual bool write(std::string_view data) override;
     virtual std::string read(unsigned timeout_sec) override;
     virtual std::string read(unsigned timeout_sec, size_t expect) override;
+    virtual bool eof() const override { return out_->eof(); }
 
 private:
     std::shared_ptr<boost::process::ipstream> out_;
@@ -2,6 +2,7 @@
 
 #include "Conf/Conf.h"
 
+#include "AdbWireIO.h"
 #include "BoostIO.h"
 
 MAA_CTRL_UNIT_NS_BEGIN
@@ -11,7 +12,18 @@ using NativeIO = BoostIO;
 class PlatformFactory
 {
 public:
-    static std::shared_ptr<PlatformIO> create() { return std::make_shared<NativeIO>(); }
+    // adb 命令优先直接走 adb server 协议，处理不了的再交给 NativeIO 起进程；
+    // adb_path 不是 adb 本身（包装脚本等）或 server 地址用了不支持的写法时，全部照常起进程
+    static std::shared_ptr<PlatformIO> create(const std::string& adb_path)
+    {
+        auto native_io = std::make_shared<NativeIO>();
+
+        auto server = AdbWireIO::server_from_env();
+        if (!server || !AdbWireIO::is_adb(adb_path)) {
+            return native_io;
+        }
+        return std::make_shared<AdbWireIO>(native_io, adb_path, std::move(server->first), server->second);
+    }
 };
 
 MAA_CTRL_UNIT_NS_END
@@ -37,6 +37,8 @@ public:
     virtual bool write(std::string_view data) = 0;
     virtual std::string read(unsigned timeout_sec) = 0;
     virtual std::string read(unsigned timeout_sec, size_t expect) = 0;
+    // 对端已关闭（或进程已退出），之后不会再有数据；read 返回空只说明超时前没读到
+    virtual bool eof() const = 0;
 };
 
 MAA_CTRL_UNIT_NS_END
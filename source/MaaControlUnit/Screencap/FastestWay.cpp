@@ -1,11 +1,38 @@
 #include "FastestWay.h"
 
 #include "Utils/Format.hpp"
+#include "Utils/InitScheduler.hpp"
 #include "Utils/Logger.h"
 #include "Utils/NoWarningCV.hpp"
 
+#include <algorithm>
+#include <future>
+#include <sstream>
+#include <vector>
+
 MAA_CTRL_UNIT_NS_BEGIN
 
+// 连接时每种方式截几次
+static constexpr int kSpeedTestSamples = 3;
+// 首次就比当前最快的慢这么多倍的，不再多测
+static constexpr int kSpeedTestGiveUpRatio = 3;
+// 每种方式保留的耗时样本数
+static constexpr size_t kStatWindow = 8;
+// 连续失败这么多次就换
+static constexpr int kMaxFailures = 3;
+// 后台重新测速的间隔
+static constexpr std::chrono::minutes kReprobeInterval(2);
+// 别的方式快到当前的这个比例以下才换，避免来回跳
+static constexpr double kSwitchRatio = 0.7;
+// 单次截图的超时为中位耗时的倍数，并限制在上下界之间
+static constexpr int kDeadlineRatio = 5;
+static constexpr std::chrono::milliseconds kMinDeadline(1000);
+static constexpr std::chrono::milliseconds kMaxDeadline(10000);
+// 初始化要推送文件、起服务，超时给得宽一些
+static constexpr std::chrono::milliseconds kInitDeadline(30000);
+// 一次截图最多尝试几种方式
+static constexpr size_t kMaxAttempts = 3;
+
 ScreencapFastestWay::ScreencapFastestWay()
 {
     units_ = {
@@ -19,9 +46,19 @@ ScreencapFastestWay::ScreencapFastestWay()
 
     for (auto pair : units_) {
         children_.emplace_back(pair.second);
+
+        auto worker = std::make_shared<Worker>();
+        worker->thread = std::thread(&ScreencapFastestWay::working, worker);
+        workers_.emplace(pair.first, std::move(worker));
     }
 }
 
+ScreencapFastestWay::~ScreencapFastestWay()
+{
+    stop_reprobe();
+    stop_workers();
+}
+
 bool ScreencapFastestWay::parse(const json::value& config)
 {
     bool ret = false;
@@ -36,10 +73,68 @@ bool ScreencapFastestWay::init(int swidth, int sheight)
 {
     LogFunc;
 
+    stop_reprobe();
+
+    swidth_ = swidth;
+    sheight_ = sheight;
+    // 各方式的初始化（推送文件、查询设备等）在各自的 worker 里同时进行；测速在 prepare 里逐个来，免得互相拖慢
+    auto step_name = [](Method method) {
+        std::stringstream ss;
+        ss << method;
+        return ss.str();
+    };
+    InitScheduler scheduler;
     for (auto pair : units_) {
-        pair.second->init(swidth, sheight);
+        auto init_unit = [this, pair, swidth, sheight]() {
+            Method method = pair.first;
+            bool stuck = is_stuck(method);
+            auto future = post(method, init_job(method, swidth, sheight, false));
+            if (stuck) {
+                // 上次的截图还卡着，init 排在它后面，不等
+                LogWarn << "unit is stuck, init it later" << VAR(method);
+                return false;
+            }
+            return wait(method, std::move(future), kInitDeadline).value_or(false);
+        };
+        scheduler.add(step_name(pair.first), init_unit);
+    }
+    scheduler.run();
+
+    // 单个方式初始化失败不影响别的，测速时自然会跳过；一个都没成功才算失败
+    bool any_inited = std::ranges::any_of(scheduler.report(), [](const auto& step) { return step.success; });
+    if (!any_inited) {
+        LogError << "no method inited";
+    }
+    return any_inited;
+}
+
+std::function<bool()> ScreencapFastestWay::init_job(Method method, int swidth, int sheight, bool reinit) const
+{
+    auto unit = units_.at(method);
+
+    // 两种 minicap 往设备上推同名的 minicap.so，不能同时推。锁在 worker 里拿，等初始化真正结束才放开，
+    // 超时不再等的那次初始化也还占着它
+    std::shared_ptr<std::mutex> push_mutex;
+    if (method == Method::MinicapDirect || method == Method::MinicapStream) {
+        push_mutex = minicap_push_mutex_;
     }
 
+    return [unit, push_mutex, swidth, sheight, reinit]() {
+        std::unique_lock<std::mutex> lock;
+        if (push_mutex) {
+            lock = std::unique_lock<std::mutex>(*push_mutex);
+        }
+        if (reinit) {
+            unit->deinit();
+        }
+        return unit->init(swidth, sheight);
+    };
+}
+
+bool ScreencapFastestWay::prepare()
+{
+    LogFunc;
+
     return speed_test();
 }
 
@@ -47,8 +142,12 @@ void ScreencapFastestWay::deinit()
 {
     LogFunc;
 
+    stop_reprobe();
+
+    // 不等它们做完：卡住的 worker 在手上的任务返回后才会执行，之后的 init 也会排在它后面
     for (auto pair : units_) {
-        pair.second->deinit();
+        auto unit = pair.second;
+        post(pair.first, [unit]() { unit->deinit(); });
     }
 
     method_ = Method::UnknownYet;
@@ -57,29 +156,143 @@ void ScreencapFastestWay::deinit()
 void ScreencapFastestWay::set_wh(int swidth, int sheight)
 {
     LogFunc;
+
+    swidth_ = swidth;
+    sheight_ = sheight;
+    for (auto pair : units_) {
+        auto unit = pair.second;
+        post(pair.first, [unit, swidth, sheight]() { unit->set_wh(swidth, sheight); });
+    }
+}
+
+void ScreencapFastestWay::set_target_size(int twidth, int theight)
+{
+    // 每次截图前都会调用，没变就不用给各个 worker 派任务
+    if (target_size_ == std::make_pair(twidth, theight)) {
+        return;
+    }
+    target_size_ = { twidth, theight };
+
+    // 排在之后的截图前面执行，不用等
     for (auto pair : units_) {
-        pair.second->set_wh(swidth, sheight);
+        auto unit = pair.second;
+        post(pair.first, [unit, twidth, theight]() { unit->set_target_size(twidth, theight); });
     }
 }
 
 std::optional<cv::Mat> ScreencapFastestWay::screencap()
 {
-    switch (method_) {
-    case Method::UnknownYet:
+    if (method_ == Method::UnknownYet) {
         LogError << "Unknown screencap method";
         return std::nullopt;
-    case Method::RawByNetcat:
-    case Method::RawWithGzip:
-    case Method::Encode:
-    case Method::EncodeToFileAndPull:
-    case Method::MinicapDirect:
-    case Method::MinicapStream:
-        return units_[method_]->screencap();
-    default:
-        LogInfo << "Not support:" << method_;
-        break;
     }
-    return std::nullopt;
+
+    std::optional<cv::Mat> ret;
+    // 后台测速正在采样的话，让它放弃这次采样，不让正常截图排在它后面
+    capture_pending_ = true;
+    std::unique_lock<std::mutex> capture_lock(capture_mutex_);
+    capture_pending_ = false;
+    for (Method method : fallback_chain()) {
+        ret = timed_screencap(method);
+        if (ret) {
+            if (method != method_) {
+                LogWarn << "screencap by fallback method" << VAR(method) << VAR(method_.load());
+            }
+            break;
+        }
+        LogWarn << "screencap failed, try next method" << VAR(method);
+
+        bool failing = false;
+        {
+            std::unique_lock<std::mutex> lock(stats_mutex_);
+            failing = stats_[method].failures >= kMaxFailures;
+        }
+        if (failing) {
+            demote(method);
+        }
+    }
+
+    capture_lock.unlock();
+
+    if (!ret) {
+        LogError << "all screencap methods failed";
+    }
+
+    check_reprobe();
+    return ret;
+}
+
+std::vector<ScreencapFastestWay::Method> ScreencapFastestWay::fallback_chain() const
+{
+    std::unique_lock<std::mutex> lock(stats_mutex_);
+
+    std::vector<std::pair<std::chrono::milliseconds, Method>> ranked;
+    for (const auto& [method, stat] : stats_) {
+        if (method == method_ || stat.demoted || stat.failures >= kMaxFailures) {
+            continue;
+        }
+        if (auto cost = median_cost(method)) {
+            ranked.emplace_back(*cost, method);
+        }
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    std::vector<Method> chain { method_.load() };
+    for (const auto& [cost, method] : ranked) {
+        if (chain.size() >= kMaxAttempts) {
+            break;
+        }
+        chain.emplace_back(method);
+    }
+    return chain;
+}
+
+void ScreencapFastestWay::demote(Method method)
+{
+    std::unique_lock<std::mutex> lock(stats_mutex_);
+
+    auto& stat = stats_[method];
+    if (stat.demoted) {
+        return;
+    }
+    stat.demoted = true;
+
+    if (method == method_) {
+        Method next = fastest(method);
+        LogWarn << "demote screencap method" << VAR(method) << VAR(next);
+        if (next != Method::UnknownYet) {
+            method_ = next;
+        }
+    }
+    else {
+        LogWarn << "demote screencap method" << VAR(method);
+    }
+
+    // 尽快在后台重新初始化
+    reprobe_requested_ = true;
+}
+
+bool ScreencapFastestWay::recover(Method method)
+{
+    LogInfo << VAR(method);
+
+    // 之前的截图还卡着，unit 还在被它用，等下次再试
+    if (is_stuck(method)) {
+        LogWarn << "unit is still stuck" << VAR(method);
+        return false;
+    }
+
+    auto inited = wait(method, post(method, init_job(method, swidth_, sheight_, true)), kInitDeadline);
+
+    if (!inited.value_or(false) || !probe_screencap(method)) {
+        LogWarn << "recover failed" << VAR(method);
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(stats_mutex_);
+    stats_[method].demoted = false;
+    LogInfo << "recovered" << VAR(method);
+    return true;
 }
 
 bool ScreencapFastestWay::speed_test()
@@ -87,33 +300,329 @@ bool ScreencapFastestWay::speed_test()
     LogFunc;
 
     method_ = Method::UnknownYet;
-    std::chrono::milliseconds cost(INT64_MAX);
+    {
+        std::unique_lock<std::mutex> lock(stats_mutex_);
+        stats_.clear();
+    }
+
+    std::optional<std::chrono::milliseconds> best_cost;
+    for (auto pair : units_) {
+        Method method = pair.first;
+        for (int i = 0; i < kSpeedTestSamples; ++i) {
+            if (!timed_screencap(method)) {
+                break;
+            }
 
-    auto check = [this, &cost](Method method, std::chrono::steady_clock::time_point start) {
-        auto duration = duration_since(start);
-        if (duration < cost) {
-            method_ = method;
-            cost = duration;
+            std::unique_lock<std::mutex> lock(stats_mutex_);
+            auto cost = median_cost(method);
+            if (best_cost && *cost > *best_cost * kSpeedTestGiveUpRatio) {
+                break;
+            }
         }
-        LogInfo << VAR(method) << VAR(duration);
-    };
 
-    for (auto pair : units_) {
-        auto now = std::chrono::steady_clock::now();
-        if (pair.second->screencap()) {
-            check(pair.first, now);
+        std::unique_lock<std::mutex> lock(stats_mutex_);
+        auto cost = median_cost(method);
+        LogInfo << VAR(method) << VAR(cost) << VAR(stats_[method].costs.size());
+        if (cost && (!best_cost || *cost < *best_cost)) {
+            best_cost = cost;
         }
     }
 
+    std::unique_lock<std::mutex> lock(stats_mutex_);
+    method_ = fastest();
     if (method_ == Method::UnknownYet) {
         LogError << "cannot find any method to screencap!";
         return false;
     }
 
-    LogInfo << "The fastest method is" << method_ << VAR(cost);
+    last_probe_ = std::chrono::steady_clock::now();
+    LogInfo << "The fastest method is" << method_.load() << VAR(best_cost);
     return true;
 }
 
+std::optional<cv::Mat> ScreencapFastestWay::timed_screencap(Method method, bool yield_to_capture)
+{
+    // 上次的截图还没返回，不再排队等它
+    if (is_stuck(method)) {
+        record(method, std::nullopt);
+        return std::nullopt;
+    }
+
+    std::chrono::milliseconds limit {};
+    {
+        std::unique_lock<std::mutex> lock(stats_mutex_);
+        limit = deadline(method);
+    }
+
+    auto unit = units_.at(method);
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    auto capture = [unit, cancelled]() {
+        // 让给正常截图后还没轮到的采样就不做了
+        if (*cancelled) {
+            return Sample {};
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto image = unit->screencap();
+        return Sample { .image = std::move(image), .cost = duration_since(start) };
+    };
+    auto sample = wait(method, post(method, capture), limit, yield_to_capture);
+    if (!sample) {
+        if (probe_exit_) {
+            return std::nullopt;
+        }
+        if (yield_to_capture && capture_pending_) {
+            // 让路不算失败，也不记耗时
+            LogDebug << "probe sample yields to capture" << VAR(method);
+            *cancelled = true;
+            return std::nullopt;
+        }
+        LogError << "screencap timeout" << VAR(method) << VAR(limit);
+        record(method, std::nullopt);
+        demote(method);
+        return std::nullopt;
+    }
+
+    record(method, sample->image ? std::make_optional(sample->cost) : std::nullopt);
+    return std::move(sample->image);
+}
+
+std::optional<cv::Mat> ScreencapFastestWay::probe_screencap(Method method)
+{
+    // 每次采样都和正常截图错开，各方式共用一个 io，有的连接（如 RawByNetcat 的监听 socket）不能同时用。
+    // 正常截图来了就放弃这次采样，正常截图最多等一个 100ms 的轮询间隔
+    std::unique_lock<std::mutex> lock(capture_mutex_);
+    return timed_screencap(method, true);
+}
+
+template <typename Func>
+std::future<std::invoke_result_t<Func>> ScreencapFastestWay::post(Method method, Func func)
+{
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Func>()>>(std::move(func));
+    auto future = task->get_future();
+
+    auto& worker = workers_.at(method);
+    {
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        worker->jobs.emplace_back([task]() { (*task)(); });
+    }
+    worker->cond.notify_one();
+    return future;
+}
+
+template <typename T>
+std::optional<T> ScreencapFastestWay::wait(Method method, std::future<T> future, std::chrono::milliseconds limit,
+                                           bool yield_to_capture)
+{
+    using namespace std::chrono_literals;
+
+    // 分段等，后台测速被叫停或要给正常截图让路时不用等满
+    auto start = std::chrono::steady_clock::now();
+    while (future.wait_for(100ms) != std::future_status::ready) {
+        if (probe_exit_ || (yield_to_capture && capture_pending_)) {
+            return std::nullopt;
+        }
+        if (duration_since(start) < limit) {
+            continue;
+        }
+
+        auto& worker = workers_.at(method);
+        std::unique_lock<std::mutex> lock(worker->mutex);
+        // 刚好在超时的时候做完了，就不算卡住
+        if (worker->busy || !worker->jobs.empty()) {
+            LogWarn << "worker is stuck" << VAR(method) << VAR(limit);
+            worker->stuck = true;
+        }
+        return std::nullopt;
+    }
+    return future.get();
+}
+
+bool ScreencapFastestWay::is_stuck(Method method) const
+{
+    auto& worker = workers_.at(method);
+    std::unique_lock<std::mutex> lock(worker->mutex);
+    return worker->stuck;
+}
+
+void ScreencapFastestWay::stop_workers()
+{
+    for (auto& [method, worker] : workers_) {
+        bool busy = false;
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->exit = true;
+            worker->jobs.clear();
+            busy = worker->busy;
+        }
+        worker->cond.notify_all();
+
+        if (busy) {
+            // 卡在 unit 里的线程等不到，让它自己结束；它只持有自己的 Worker 和 unit
+            LogWarn << "abandon busy worker" << VAR(method);
+            worker->thread.detach();
+        }
+        else {
+            worker->thread.join();
+        }
+    }
+}
+
+void ScreencapFastestWay::working(std::shared_ptr<Worker> worker)
+{
+    std::unique_lock<std::mutex> lock(worker->mutex);
+    while (true) {
+        worker->cond.wait(lock, [&]() { return worker->exit || !worker->jobs.empty(); });
+        if (worker->exit) {
+            return;
+        }
+
+        auto job = std::move(worker->jobs.front());
+        worker->jobs.pop_front();
+        worker->busy = true;
+
+        lock.unlock();
+        job();
+        lock.lock();
+
+        worker->busy = false;
+        worker->stuck = false;
+    }
+}
+
+void ScreencapFastestWay::check_reprobe()
+{
+    // 只在 action 线程中调用
+    if (probing_ || (!reprobe_requested_ && duration_since(last_probe_) < kReprobeInterval)) {
+        return;
+    }
+    reprobe_requested_ = false;
+
+    if (probe_thread_.joinable()) {
+        probe_thread_.join();
+    }
+
+    last_probe_ = std::chrono::steady_clock::now();
+    probing_ = true;
+    probe_exit_ = false;
+    probe_thread_ = std::thread(&ScreencapFastestWay::reprobe, this);
+}
+
+void ScreencapFastestWay::reprobe()
+{
+    LogFunc;
+
+    for (auto pair : units_) {
+        Method method = pair.first;
+
+        bool demoted = false;
+        {
+            std::unique_lock<std::mutex> lock(stats_mutex_);
+            demoted = stats_[method].demoted;
+        }
+        if (method == method_ && !demoted) {
+            // 当前方式的耗时一直在正常截图中统计
+            continue;
+        }
+        if (demoted && !recover(method)) {
+            continue;
+        }
+
+        for (int i = 0; i < kSpeedTestSamples && !probe_exit_; ++i) {
+            if (!probe_screencap(method)) {
+                break;
+            }
+        }
+        if (probe_exit_) {
+            break;
+        }
+    }
+
+    if (!probe_exit_) {
+        std::unique_lock<std::mutex> lock(stats_mutex_);
+        Method current = method_;
+        Method best = fastest();
+        auto current_cost = median_cost(current);
+        auto best_cost = median_cost(best);
+
+        LogInfo << VAR(current) << VAR(current_cost) << VAR(best) << VAR(best_cost);
+        if (best != Method::UnknownYet && best != current &&
+            (!current_cost || best_cost->count() < current_cost->count() * kSwitchRatio)) {
+            LogInfo << "switch to faster method" << VAR(current) << VAR(best);
+            method_ = best;
+        }
+    }
+
+    probing_ = false;
+}
+
+void ScreencapFastestWay::stop_reprobe()
+{
+    probe_exit_ = true;
+    if (probe_thread_.joinable()) {
+        probe_thread_.join();
+    }
+    probing_ = false;
+    // 之后 action 线程自己的等待不能被它打断
+    probe_exit_ = false;
+}
+
+void ScreencapFastestWay::record(Method method, std::optional<std::chrono::milliseconds> cost)
+{
+    std::unique_lock<std::mutex> lock(stats_mutex_);
+
+    auto& stat = stats_[method];
+    if (!cost) {
+        ++stat.failures;
+        return;
+    }
+
+    stat.failures = 0;
+    stat.costs.emplace_back(*cost);
+    if (stat.costs.size() > kStatWindow) {
+        stat.costs.pop_front();
+    }
+}
+
+std::optional<std::chrono::milliseconds> ScreencapFastestWay::median_cost(Method method) const
+{
+    auto iter = stats_.find(method);
+    if (iter == stats_.end() || iter->second.costs.empty()) {
+        return std::nullopt;
+    }
+
+    std::vector<std::chrono::milliseconds> costs(iter->second.costs.begin(), iter->second.costs.end());
+    auto mid = costs.begin() + costs.size() / 2;
+    std::nth_element(costs.begin(), mid, costs.end());
+    return *mid;
+}
+
+ScreencapFastestWay::Method ScreencapFastestWay::fastest(Method except) const
+{
+    Method best = Method::UnknownYet;
+    std::optional<std::chrono::milliseconds> best_cost;
+
+    for (const auto& [method, stat] : stats_) {
+        if (method == except || stat.demoted || stat.failures >= kMaxFailures) {
+            continue;
+        }
+        auto cost = median_cost(method);
+        if (cost && (!best_cost || *cost < *best_cost)) {
+            best = method;
+            best_cost = cost;
+        }
+    }
+    return best;
+}
+
+std::chrono::milliseconds ScreencapFastestWay::deadline(Method method) const
+{
+    auto cost = median_cost(method);
+    if (!cost) {
+        return kMaxDeadline;
+    }
+    return std::clamp(*cost * kDeadlineRatio, kMinDeadline, kMaxDeadline);
+}
+
 std::ostream& operator<<(std::ostream& os, ScreencapFastestWay::Method m)
 {
     switch (m) {
@@ -7,6 +7,18 @@
 #include "RawByNetcat.h"
 #include "RawWithGzip.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
 MAA_CTRL_UNIT_NS_BEGIN
 
 class ScreencapFastestWay : public ScreencapBase
@@ -25,23 +37,100 @@ public:
 
 public:
     ScreencapFastestWay();
-    virtual ~ScreencapFastestWay() override = default;
+    virtual ~ScreencapFastestWay() override;
 
 public: // from UnitBase
     virtual bool parse(const json::value& config) override;
 
 public: // from ScreencapAPI
     virtual bool init(int swidth, int sheight) override;
+    virtual bool prepare() override;
     virtual void deinit() override;
     virtual void set_wh(int swidth, int sheight) override;
+    virtual void set_target_size(int twidth, int theight) override;
 
     virtual std::optional<cv::Mat> screencap() override;
 
 private:
+    // 每种方式最近若干次的耗时，取中位数，一两次抖动不会影响选择
+    struct Stat
+    {
+        std::deque<std::chrono::milliseconds> costs;
+        int failures = 0; // 连续失败次数
+        bool demoted = false; // 超时或连续失败，等待后台重新初始化
+    };
+
+    // 每种方式一个常驻线程，unit 的所有操作（初始化、截图、改尺寸）都排队在里面执行，unit 因此不用加锁。
+    // 线程只持有 Worker 和 unit 的 shared_ptr，不碰 this：任务超时就不再等它，析构时也不 join 卡住的线程
+    struct Worker
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::deque<std::function<void()>> jobs;
+        bool busy = false;
+        bool stuck = false; // 有任务超时还没返回，之后的截图不再派给它
+        bool exit = false;
+        std::thread thread;
+    };
+
+    struct Sample
+    {
+        std::optional<cv::Mat> image;
+        std::chrono::milliseconds cost {};
+    };
+
+    // 在 worker 里执行的（重新）初始化
+    std::function<bool()> init_job(Method method, int swidth, int sheight, bool reinit) const;
     bool speed_test();
+    std::optional<cv::Mat> timed_screencap(Method method, bool yield_to_capture = false);
+    // 后台测速用，和正常截图互斥
+    std::optional<cv::Mat> probe_screencap(Method method);
+    std::vector<Method> fallback_chain() const;
+    void demote(Method method);
+    bool recover(Method method);
+
+    template <typename Func>
+    std::future<std::invoke_result_t<Func>> post(Method method, Func func);
+    // 超时返回 nullopt 并把 worker 标记为卡住；后台测速被叫停、或 yield_to_capture 时有正常截图在等，也会提前返回
+    template <typename T>
+    std::optional<T> wait(Method method, std::future<T> future, std::chrono::milliseconds limit,
+                          bool yield_to_capture = false);
+    bool is_stuck(Method method) const;
+    void stop_workers();
+    static void working(std::shared_ptr<Worker> worker);
+
+    void check_reprobe();
+    void reprobe();
+    void stop_reprobe();
+
+    void record(Method method, std::optional<std::chrono::milliseconds> cost);
+    // 以下需持有 stats_mutex_
+    std::optional<std::chrono::milliseconds> median_cost(Method method) const;
+    Method fastest(Method except = Method::UnknownYet) const;
+    std::chrono::milliseconds deadline(Method method) const;
 
     std::map<Method, std::shared_ptr<ScreencapBase>> units_;
-    Method method_ = Method::UnknownYet;
+    std::map<Method, std::shared_ptr<Worker>> workers_;
+    // 被 worker 里的初始化任务持有，卡住被放弃的 worker 也能安全地用
+    std::shared_ptr<std::mutex> minicap_push_mutex_ = std::make_shared<std::mutex>();
+    // 同一时间只跑一次截图：后台测速的采样不和正常截图同时用 io
+    std::mutex capture_mutex_;
+    // 正常截图在等 capture_mutex_，后台测速的采样见到后让路
+    std::atomic_bool capture_pending_ = false;
+    std::atomic<Method> method_ = Method::UnknownYet;
+    std::pair<int, int> target_size_ = { 0, 0 };
+    // 后台重新初始化时使用
+    std::atomic_int swidth_ = 0;
+    std::atomic_int sheight_ = 0;
+
+    mutable std::mutex stats_mutex_;
+    std::map<Method, Stat> stats_;
+
+    std::chrono::steady_clock::time_point last_probe_;
+    std::atomic_bool probing_ = false;
+    std::atomic_bool probe_exit_ = false;
+    std::atomic_bool reprobe_requested_ = false;
+    std::thread probe_thread_;
 };
 
 std::ostream& operator<<(std::ostream& os, ScreencapFastestWay::Method m);
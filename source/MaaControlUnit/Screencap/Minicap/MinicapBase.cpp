@@ -136,4 +136,30 @@ bool MinicapBase::init(int swidth, int sheight)
     return true;
 }
 
+void MinicapBase::set_target_size(int twidth, int theight)
+{
+    ScreencapBase::set_target_size(twidth, theight);
+
+    target_width_ = twidth;
+    target_height_ = theight;
+}
+
+std::pair<int, int> MinicapBase::virtual_size() const
+{
+    int width = screencap_helper_.get_w();
+    int height = screencap_helper_.get_h();
+
+    if (target_width_ <= 0 || target_height_ <= 0 || target_width_ > width || target_height_ > height) {
+        return { width, height };
+    }
+    return { target_width_, target_height_ };
+}
+
+std::string MinicapBase::projection() const
+{
+    auto [vwidth, vheight] = virtual_size();
+    return MAA_FMT::format("-P {}x{}@{}x{}/{}", screencap_helper_.get_w(), screencap_helper_.get_h(), vwidth,
+                           vheight, 0);
+}
+
 MAA_CTRL_UNIT_NS_END
@@ -23,9 +23,14 @@ public: // from UnitBase
 public: // from ScreencapAPI
     virtual bool init(int swidth, int sheight) override;
     virtual void deinit() override {}
+    virtual void set_target_size(int twidth, int theight) override;
     virtual std::optional<cv::Mat> screencap() override = 0;
 
 protected:
+    // 让 minicap 在设备上直接缩放到目标尺寸再编码，目标未知或比屏幕大时使用原始尺寸
+    std::pair<int, int> virtual_size() const;
+    std::string projection() const;
+
     std::shared_ptr<InvokeApp> binary_ = std::make_shared<InvokeApp>();
     std::shared_ptr<InvokeApp> library_ = std::make_shared<InvokeApp>();
 
@@ -33,6 +38,9 @@ private:
     std::string root_;
     std::vector<std::string> arch_list_;
     std::vector<int> sdk_list_;
+
+    int target_width_ = 0;
+    int target_height_ = 0;
 };
 
 MAA_CTRL_UNIT_NS_END
@@ -1,17 +1,13 @@
 #include "MinicapDirect.h"
 
 #include "Utils/Logger.h"
-#include "Utils/Format.hpp"
 #include "Utils/NoWarningCV.hpp"
 
 MAA_CTRL_UNIT_NS_BEGIN
 
 std::optional<cv::Mat> MinicapDirect::screencap()
 {
-    int width = screencap_helper_.get_w();
-    int height = screencap_helper_.get_h();
-
-    auto res = binary_->invoke_bin_stdout(MAA_FMT::format("-P {}x{}@{}x{}/{} -s", width, height, width, height, 0));
+    auto res = binary_->invoke_bin_stdout(projection() + " -s");
 
     if (!res) {
         return std::nullopt;
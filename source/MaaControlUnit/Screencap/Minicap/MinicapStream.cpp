@@ -7,6 +7,13 @@
 
 MAA_CTRL_UNIT_NS_BEGIN
 
+static constexpr size_t kRingCapacity = 4 * 1024 * 1024;
+
+MinicapStream::~MinicapStream()
+{
+    deinit();
+}
+
 bool MinicapStream::parse(const json::value& config)
 {
     return MinicapBase::parse(config) && parse_argv("ForwardSocket", config, forward_argv_);
@@ -16,10 +23,23 @@ bool MinicapStream::init(int swidth, int sheight)
 {
     LogFunc;
 
+    deinit();
+
     if (!MinicapBase::init(swidth, sheight)) {
         return false;
     }
 
+    return start_stream();
+}
+
+bool MinicapStream::start_stream()
+{
+    LogFunc;
+
+    ring_.resize(kRingCapacity);
+    ring_head_ = 0;
+    ring_size_ = 0;
+
     // TODO: 也许可以允许配置?
     merge_replacement({ { "{FOWARD_PORT}", "1313" }, { "{LOCAL_SOCKET}", "minicap" } });
     auto cmd_ret = command(forward_argv_.gen(argv_replace_));
@@ -30,8 +50,10 @@ bool MinicapStream::init(int swidth, int sheight)
 
     uint32_t width = screencap_helper_.get_w();
     uint32_t height = screencap_helper_.get_h();
+    stream_virtual_size_ = virtual_size();
+    auto [vwidth, vheight] = stream_virtual_size_;
 
-    process_handle_ = binary_->invoke_bin(MAA_FMT::format("-P {}x{}@{}x{}/{}", width, height, width, height, 0));
+    process_handle_ = binary_->invoke_bin(projection());
 
     if (!process_handle_) {
         return false;
@@ -43,6 +65,10 @@ bool MinicapStream::init(int swidth, int sheight)
         if (res.find("Allocating") != std::string::npos) {
             break;
         }
+        if (process_handle_->eof()) {
+            LogError << "minicap exited before streaming";
+            return false;
+        }
     }
 
     auto serial_host = argv_replace_["{ADB_SERIAL}"];
@@ -75,8 +101,8 @@ bool MinicapStream::init(int swidth, int sheight)
         return false;
     }
 
-    if (header.real_width != width || header.real_height != height || header.virt_width != width ||
-        header.virt_height != height) {
+    if (header.real_width != width || header.real_height != height ||
+        header.virt_width != static_cast<uint32_t>(vwidth) || header.virt_height != static_cast<uint32_t>(vheight)) {
         return false;
     }
 
@@ -85,61 +111,181 @@ bool MinicapStream::init(int swidth, int sheight)
         return false;
     }
 
+    running_ = true;
+    reader_ = std::thread(&MinicapStream::reading, this);
+
     return true;
 }
 
+void MinicapStream::deinit()
+{
+    running_ = false;
+    frame_cond_.notify_all();
+
+    // 结束 minicap 进程，socket 随之关闭，reader 的阻塞读会返回
+    process_handle_ = nullptr;
+
+    if (reader_.joinable()) {
+        reader_.join();
+    }
+    stream_handle_ = nullptr;
+
+    {
+        std::unique_lock<std::mutex> lock(frame_mutex_);
+        latest_frame_ = nullptr;
+    }
+    decoded_image_ = cv::Mat();
+    decoded_seq_ = 0;
+}
+
+void MinicapStream::set_target_size(int twidth, int theight)
+{
+    MinicapBase::set_target_size(twidth, theight);
+
+    if (!running_ || virtual_size() == stream_virtual_size_) {
+        return;
+    }
+
+    // 缩放尺寸是启动参数，只能重启 minicap
+    LogInfo << "restart minicap for new projection" << VAR(twidth) << VAR(theight);
+    deinit();
+    if (!start_stream()) {
+        LogError << "failed to restart minicap";
+    }
+}
+
 std::optional<cv::Mat> MinicapStream::screencap()
 {
-    if (!stream_handle_) {
-        return std::nullopt;
+    std::shared_ptr<const std::string> frame;
+    uint64_t seq = 0;
+    {
+        std::unique_lock<std::mutex> lock(frame_mutex_);
+
+        // minicap 只在画面变化时推帧，所以最新收到的一帧就是当前画面
+        using namespace std::chrono_literals;
+        frame_cond_.wait_for(lock, 5s, [&]() { return latest_frame_ || !running_; });
+        // 流断了以后最后一帧已经不是当前画面，不能再返回
+        if (!running_ || !latest_frame_) {
+            LogError << "stream is not running or no frame received yet" << VAR(running_);
+            return std::nullopt;
+        }
+        frame = latest_frame_;
+        seq = frame_seq_;
     }
 
-    uint32_t size;
-    if (!take_out(&size, 4)) {
-        LogError << "take_out size failed";
-        return std::nullopt;
+    if (seq == decoded_seq_ && !decoded_image_.empty()) {
+        return decoded_image_;
     }
 
-    if (!read_until(size)) {
-        LogError << "read_until size failed";
+    auto image = screencap_helper_.decode_jpg(*frame);
+    if (!image) {
+        LogError << "decode_jpg failed" << VAR(frame->size());
         return std::nullopt;
     }
 
-    auto data = std::move(buffer_);
-    buffer_.clear();
-
-    return screencap_helper_.process_data(
-        data, std::bind(&ScreencapHelper::decode_jpg, &screencap_helper_, std::placeholders::_1));
+    // 每帧都是新解码出来的 Mat，之后不会再写它，浅拷贝即可
+    decoded_image_ = std::move(*image);
+    decoded_seq_ = seq;
+    return decoded_image_;
 }
 
-bool MinicapStream::read_until(size_t size)
+void MinicapStream::reading()
 {
     LogFunc;
 
+    // 画面不动时 minicap 不推帧，读超时是正常的，只有连接断开才退出
+    auto wait_for = [&](size_t size) {
+        while (running_) {
+            if (read_until(size)) {
+                return true;
+            }
+            if (stream_handle_->eof()) {
+                LogError << "minicap stream closed";
+                return false;
+            }
+        }
+        return false;
+    };
+
+    while (running_) {
+        if (!wait_for(4)) {
+            break;
+        }
+        uint32_t size = 0;
+        take_out(&size, 4);
+
+        if (!wait_for(size)) {
+            break;
+        }
+
+        auto frame = std::make_shared<std::string>(size, '\0');
+        take_out(frame->data(), size);
+
+        {
+            // 没被取走解码的旧帧直接丢弃
+            std::unique_lock<std::mutex> lock(frame_mutex_);
+            latest_frame_ = std::move(frame);
+            ++frame_seq_;
+        }
+        frame_cond_.notify_all();
+    }
+
+    // minicap 挂了或者 socket 断了：让 screencap 报错，好让上层换别的方式
+    {
+        std::unique_lock<std::mutex> lock(frame_mutex_);
+        running_ = false;
+        latest_frame_ = nullptr;
+    }
+    frame_cond_.notify_all();
+}
+
+bool MinicapStream::read_until(size_t size)
+{
     using namespace std::chrono_literals;
     auto start = std::chrono::steady_clock::now();
 
-    while (buffer_.size() < size && duration_since(start) < 5s) {
-        auto ret = stream_handle_->read(2, size - buffer_.size());
-        buffer_.insert(buffer_.end(), ret.begin(), ret.end());
+    if (size > ring_.size()) {
+        // 线性化后扩容
+        std::vector<char> bigger(std::max(size, ring_.size() * 2));
+        const size_t buffered = ring_size_;
+        take_out(bigger.data(), buffered);
+        ring_.swap(bigger);
+        ring_head_ = 0;
+        ring_size_ = buffered;
     }
 
-    return buffer_.size() == size;
+    while (ring_size_ < size && duration_since(start) < 5s && !stream_handle_->eof()) {
+        auto ret = stream_handle_->read(2, size - ring_size_);
+        push_back(ret);
+    }
+
+    return ring_size_ >= size;
 }
 
 bool MinicapStream::take_out(void* out, size_t size)
 {
-    LogFunc;
-
     if (!read_until(size)) {
         return false;
     }
+
     if (out) {
-        memcpy(out, buffer_.c_str(), size);
+        const size_t first = std::min(size, ring_.size() - ring_head_);
+        memcpy(out, ring_.data() + ring_head_, first);
+        memcpy(static_cast<char*>(out) + first, ring_.data(), size - first);
     }
-    buffer_.erase(0, size);
+    ring_head_ = (ring_head_ + size) % ring_.size();
+    ring_size_ -= size;
 
     return true;
 }
 
+void MinicapStream::push_back(const std::string& data)
+{
+    const size_t tail = (ring_head_ + ring_size_) % ring_.size();
+    const size_t first = std::min(data.size(), ring_.size() - tail);
+    memcpy(ring_.data() + tail, data.data(), first);
+    memcpy(ring_.data(), data.data() + first, data.size() - first);
+    ring_size_ += data.size();
+}
+
 MAA_CTRL_UNIT_NS_END
@@ -2,30 +2,62 @@
 
 #include "MinicapBase.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 MAA_CTRL_UNIT_NS_BEGIN
 
 class MinicapStream : public MinicapBase
 {
 public:
-    virtual ~MinicapStream() override = default;
+    virtual ~MinicapStream() override;
 
 public: // from UnitBase
     virtual bool parse(const json::value& config) override;
 
 public: // from ScreencapAPI
     virtual bool init(int swidth, int sheight) override;
+    virtual void deinit() override;
+    virtual void set_target_size(int twidth, int theight) override;
 
     virtual std::optional<cv::Mat> screencap() override;
 
 private:
+    bool start_stream();
+
     bool read_until(size_t size);
     bool take_out(void* out, size_t size);
+    void push_back(const std::string& data);
+
+    void reading();
 
     Argv forward_argv_;
 
-    std::string buffer_;
+    // 固定容量的环形缓冲，帧比容量大时才扩容
+    std::vector<char> ring_;
+    size_t ring_head_ = 0;
+    size_t ring_size_ = 0;
+
+    std::pair<int, int> stream_virtual_size_ = { 0, 0 };
     std::shared_ptr<IOHandler> process_handle_;
     std::shared_ptr<IOHandler> stream_handle_;
+
+    std::atomic_bool running_ = false;
+    std::thread reader_;
+
+    // reader 只保留最新一帧的 jpg，screencap 时才解码：没被选中的方式在后台只收不解
+    std::mutex frame_mutex_;
+    std::condition_variable frame_cond_;
+    std::shared_ptr<const std::string> latest_frame_;
+    uint64_t frame_seq_ = 0;
+
+    // 画面不动时连续截图拿到的是同一帧，不重复解码；只在 screencap 中访问
+    cv::Mat decoded_image_;
+    uint64_t decoded_seq_ = 0;
 };
 
 MAA_CTRL_UNIT_NS_END
@@ -0,0 +1,291 @@
+#include "RawStream.h"
+
+#include <cstring>
+
+#include "Utils/Logger.h"
+
+MAA_CTRL_UNIT_NS_BEGIN
+
+// 每帧前由设备端输出，用于校验帧边界和推断 screencap 的头长度
+static constexpr std::string_view kFrameMarker = "MAAFRAME";
+static constexpr unsigned short kStreamPort = 1314;
+static constexpr unsigned kReadTimeout = 5;
+
+ScreencapRawStream::~ScreencapRawStream()
+{
+    deinit();
+}
+
+bool ScreencapRawStream::parse(const json::value& config)
+{
+    return parse_argv("ScreencapRawStream", config, screencap_raw_stream_argv_) &&
+           parse_argv("ForwardTcp", config, forward_argv_);
+}
+
+bool ScreencapRawStream::init(int swidth, int sheight)
+{
+    LogFunc;
+
+    deinit();
+    set_wh(swidth, sheight);
+
+    if (!io_ptr_) {
+        LogError << "io_ptr is nullptr";
+        return false;
+    }
+
+    merge_replacement({ { "{FOWARD_PORT}", std::to_string(kStreamPort) },
+                        { "{REMOTE_PORT}", std::to_string(kStreamPort) } });
+    if (!command(forward_argv_.gen(argv_replace_))) {
+        return false;
+    }
+
+    process_handle_ = io_ptr_->interactive_shell(screencap_raw_stream_argv_.gen(argv_replace_));
+    if (!process_handle_) {
+        LogError << "failed to start device loop";
+        return false;
+    }
+
+    if (!connect_stream() || !detect_header_size()) {
+        deinit();
+        return false;
+    }
+
+    running_ = true;
+    reader_ = std::thread(&ScreencapRawStream::reading, this);
+
+    return true;
+}
+
+void ScreencapRawStream::deinit()
+{
+    running_ = false;
+
+    // 结束设备端循环，socket 随之关闭，reader 线程的阻塞读会返回
+    process_handle_ = nullptr;
+
+    if (reader_.joinable()) {
+        reader_.join();
+    }
+    stream_handle_ = nullptr;
+
+    std::unique_lock<std::mutex> lock(slot_mutex_);
+    latest_slot_ = SIZE_MAX;
+    reading_slot_ = SIZE_MAX;
+    header_size_ = 0;
+    marker_consumed_ = false;
+}
+
+std::optional<cv::Mat> ScreencapRawStream::screencap()
+{
+    size_t slot = SIZE_MAX;
+    {
+        std::unique_lock<std::mutex> lock(slot_mutex_);
+        using namespace std::chrono_literals;
+        slot_cond_.wait_for(lock, kReadTimeout * 1s, [&]() { return latest_slot_ != SIZE_MAX || !running_; });
+        if (!running_ || latest_slot_ == SIZE_MAX) {
+            LogError << "stream is not running or no frame yet" << VAR(running_);
+            return std::nullopt;
+        }
+        slot = latest_slot_;
+        reading_slot_ = slot;
+    }
+
+    auto res = screencap_helper_.decode_raw(slots_.at(slot));
+
+    std::unique_lock<std::mutex> lock(slot_mutex_);
+    reading_slot_ = SIZE_MAX;
+
+    return res;
+}
+
+bool ScreencapRawStream::connect_stream()
+{
+    LogFunc;
+
+    auto serial_host = argv_replace_["{ADB_SERIAL}"];
+    auto shp = serial_host.find(':');
+    std::string local = "127.0.0.1";
+    if (shp != std::string::npos) {
+        local = serial_host.substr(0, shp);
+    }
+
+    // 设备端 nc 开始监听前，forward 会接受连接后立即断开，所以要重试
+    constexpr int kRetryTimes = 10;
+    for (int i = 0; i != kRetryTimes; ++i) {
+        using namespace std::chrono_literals;
+        std::this_thread::sleep_for(200ms);
+
+        try {
+            stream_handle_ = io_ptr_->tcp(local, kStreamPort);
+        }
+        catch (const std::exception& e) {
+            LogWarn << "connect failed" << VAR(local) << VAR(kStreamPort) << VAR(e.what());
+            continue;
+        }
+        if (!stream_handle_) {
+            continue;
+        }
+
+        std::string marker;
+        if (read_exact(marker, kFrameMarker.size()) && marker == kFrameMarker) {
+            marker_consumed_ = true;
+            return true;
+        }
+        LogWarn << "no frame marker yet" << VAR(i) << VAR(marker.size());
+    }
+
+    LogError << "failed to connect stream" << VAR(local) << VAR(kStreamPort);
+    stream_handle_ = nullptr;
+    return false;
+}
+
+bool ScreencapRawStream::detect_header_size()
+{
+    LogFunc;
+
+    // screencap 的头为 width, height, format，部分版本还多一个 4 字节的 colorspace
+    // 读 12 字节头 + 像素 + 下一帧的 marker，看 marker 落在哪里即可确定头长度
+    constexpr size_t kBaseHeaderSize = 12;
+    constexpr size_t kExtHeaderSize = 16;
+
+    const size_t pixel_size = 4ULL * screencap_helper_.get_w() * screencap_helper_.get_h();
+
+    std::string data;
+    if (!read_exact(data, kBaseHeaderSize + pixel_size + kFrameMarker.size())) {
+        LogError << "failed to read first frame";
+        return false;
+    }
+
+    if (std::string_view(data).substr(kBaseHeaderSize + pixel_size) == kFrameMarker) {
+        header_size_ = kBaseHeaderSize;
+    }
+    else {
+        std::string extra;
+        if (!read_exact(extra, kExtHeaderSize - kBaseHeaderSize)) {
+            LogError << "failed to read first frame";
+            return false;
+        }
+        data.append(extra);
+        if (std::string_view(data).substr(kExtHeaderSize + pixel_size) != kFrameMarker) {
+            LogError << "unknown frame layout" << VAR(data.size());
+            return false;
+        }
+        header_size_ = kExtHeaderSize;
+    }
+
+    LogInfo << VAR(header_size_);
+
+    data.resize(header_size_ + pixel_size);
+    {
+        std::unique_lock<std::mutex> lock(slot_mutex_);
+        slots_.front() = std::move(data);
+        latest_slot_ = 0;
+    }
+    marker_consumed_ = true;
+
+    return true;
+}
+
+bool ScreencapRawStream::read_frame(std::string& frame)
+{
+    if (!marker_consumed_) {
+        std::string marker;
+        if (!read_exact(marker, kFrameMarker.size()) || marker != kFrameMarker) {
+            LogWarn << "frame marker mismatch";
+            return false;
+        }
+    }
+    marker_consumed_ = false;
+
+    if (!read_exact(frame, frame_size())) {
+        return false;
+    }
+
+    uint32_t im_width = 0, im_height = 0;
+    memcpy(&im_width, frame.data(), 4);
+    memcpy(&im_height, frame.data() + 4, 4);
+    if (static_cast<int>(im_width) != screencap_helper_.get_w() ||
+        static_cast<int>(im_height) != screencap_helper_.get_h()) {
+        LogWarn << "frame size mismatch" << VAR(im_width) << VAR(im_height);
+        return false;
+    }
+
+    return true;
+}
+
+bool ScreencapRawStream::read_exact(std::string& out, size_t size)
+{
+    if (!stream_handle_) {
+        return false;
+    }
+
+    out = stream_handle_->read(kReadTimeout, size);
+    return out.size() == size;
+}
+
+bool ScreencapRawStream::resync()
+{
+    LogFunc;
+
+    // 逐字节找下一个 marker，最多找两帧的长度
+    const size_t limit = 2 * (kFrameMarker.size() + frame_size());
+    std::string window;
+    for (size_t i = 0; i != limit && running_; ++i) {
+        std::string byte;
+        if (!read_exact(byte, 1)) {
+            return false;
+        }
+        window.append(byte);
+        if (window.size() > kFrameMarker.size()) {
+            window.erase(0, 1);
+        }
+        if (window == kFrameMarker) {
+            marker_consumed_ = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ScreencapRawStream::reading()
+{
+    LogFunc;
+
+    while (running_) {
+        size_t slot = 0;
+        {
+            std::unique_lock<std::mutex> lock(slot_mutex_);
+            while (slot == latest_slot_ || slot == reading_slot_) {
+                ++slot;
+            }
+        }
+
+        if (!read_frame(slots_.at(slot))) {
+            if (!running_) {
+                break;
+            }
+            if (!resync()) {
+                LogError << "stream broken";
+                break;
+            }
+            continue;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(slot_mutex_);
+            latest_slot_ = slot;
+        }
+        slot_cond_.notify_all();
+    }
+
+    running_ = false;
+    slot_cond_.notify_all();
+}
+
+size_t ScreencapRawStream::frame_size() const
+{
+    return header_size_ + 4ULL * screencap_helper_.get_w() * screencap_helper_.get_h();
+}
+
+MAA_CTRL_UNIT_NS_END
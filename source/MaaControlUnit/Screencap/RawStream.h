@@ -0,0 +1,61 @@
+#pragma once
+
+#include "UnitBase.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "ScreencapHelper.h"
+
+MAA_CTRL_UNIT_NS_BEGIN
+
+// 设备端常驻循环持续 screencap，经 adb forward 的 socket 推流，本地只保留最新的完整帧
+class ScreencapRawStream : public ScreencapBase
+{
+public:
+    virtual ~ScreencapRawStream() override;
+
+public: // from UnitBase
+    virtual bool parse(const json::value& config) override;
+
+public: // from ScreencapAPI
+    virtual bool init(int swidth, int sheight) override;
+    virtual void deinit() override;
+
+    virtual std::optional<cv::Mat> screencap() override;
+
+private:
+    bool connect_stream();
+    bool detect_header_size();
+    bool read_frame(std::string& frame);
+    bool read_exact(std::string& out, size_t size);
+    bool resync();
+    void reading();
+
+    size_t frame_size() const;
+
+    Argv screencap_raw_stream_argv_;
+    Argv forward_argv_;
+
+    std::shared_ptr<IOHandler> process_handle_;
+    std::shared_ptr<IOHandler> stream_handle_;
+
+    size_t header_size_ = 0;
+    bool marker_consumed_ = false;
+
+    // 帧环形缓冲：reader 线程只写既不是 latest_ 也不是 reading_slot_ 的槽
+    static constexpr size_t kSlotCount = 3;
+    std::array<std::string, kSlotCount> slots_;
+    size_t latest_slot_ = SIZE_MAX;
+    size_t reading_slot_ = SIZE_MAX;
+    std::mutex slot_mutex_;
+    std::condition_variable slot_cond_;
+
+    std::atomic_bool running_ = false;
+    std::thread reader_;
+};
+
+MAA_CTRL_UNIT_NS_END
@@ -20,6 +20,17 @@ void ScreencapHelper::set_wh(int w, int h)
     height_ = h;
 }
 
+void ScreencapHelper::set_target_size(int w, int h)
+{
+    if (w == target_width_ && h == target_height_) {
+        return;
+    }
+
+    LogInfo << VAR(w) << VAR(h);
+    target_width_ = w;
+    target_height_ = h;
+}
+
 std::optional<cv::Mat> ScreencapHelper::process_data(
     std::string& buffer, std::function<std::optional<cv::Mat>(const std::string& buffer)> decoder)
 {
@@ -126,8 +137,21 @@ std::optional<cv::Mat> ScreencapHelper::decode_raw(const std::string& buffer)
     if (br[3] != 255) { // only check alpha
         return std::nullopt;
     }
-    cv::cvtColor(temp, temp, cv::COLOR_RGBA2BGR);
-    return temp.clone(); // temp只是引用data, 需要clone确保数据拥有所有权
+
+    // temp 只是引用 data，结果写进池里的 buffer，不再 clone
+    int target_width = target_width_;
+    int target_height = target_height_;
+    if (target_width <= 0 || target_height <= 0 || target_width >= width_ || target_height >= height_) {
+        cv::Mat image = frame_pool_.acquire(height_, width_, CV_8UC3);
+        cv::cvtColor(temp, image, cv::COLOR_RGBA2BGR);
+        return image;
+    }
+
+    // 先在 RGBA 上缩到目标尺寸再转 BGR，全尺寸的数据只读一遍，也不会产生全尺寸的中间图
+    cv::resize(temp, scaled_rgba_, { target_width, target_height });
+    cv::Mat image = frame_pool_.acquire(target_height, target_width, CV_8UC3);
+    cv::cvtColor(scaled_rgba_, image, cv::COLOR_RGBA2BGR);
+    return image;
 }
 
 std::optional<cv::Mat> ScreencapHelper::decode_gzip(const std::string& buffer)
@@ -143,18 +167,18 @@ std::optional<cv::Mat> ScreencapHelper::decode_png(const std::string& buffer)
         return std::nullopt;
     }
 
-    return temp.clone();
+    return temp;
 }
 
 // 是直接就能实现的吧?
 std::optional<cv::Mat> ScreencapHelper::decode_jpg(const std::string& buffer)
 {
-    cv::Mat temp = cv::imdecode({ buffer.data(), int(buffer.size()) }, cv::IMREAD_COLOR);
+    cv::Mat temp = cv::imdecode({ buffer.data(), int(buffer.size()) }, jpg_imread_flag(buffer));
     if (temp.empty()) {
         return std::nullopt;
     }
 
-    return temp.clone();
+    return temp;
 }
 
 // 是直接就能实现的吧?
@@ -173,12 +197,83 @@ std::optional<cv::Mat> ScreencapHelper::decode_jpg_with_minicap_header(const std
 
     auto data = buffer.substr(begin, end - begin + 2);
 
-    cv::Mat temp = cv::imdecode({ data.data(), int(data.size()) }, cv::IMREAD_COLOR);
+    cv::Mat temp = cv::imdecode({ data.data(), int(data.size()) }, jpg_imread_flag(data));
     if (temp.empty()) {
         return std::nullopt;
     }
 
-    return temp.clone();
+    return temp;
+}
+
+int ScreencapHelper::jpg_imread_flag(std::string_view jpg) const
+{
+    int target_width = target_width_;
+    int target_height = target_height_;
+    if (target_width <= 0 || target_height <= 0) {
+        return cv::IMREAD_COLOR;
+    }
+
+    // minicap 可能已经在设备上缩放过，以 jpg 自身的尺寸为准
+    auto [width, height] = jpg_size(jpg).value_or(std::make_pair(width_, height_));
+    if (width <= 0 || height <= 0) {
+        return cv::IMREAD_COLOR;
+    }
+
+    // libjpeg 的 DCT 缩放解码，输出尺寸为 ceil(src / denom)，取不小于目标尺寸的最小一档，剩下的交给后面的 resize
+    constexpr std::pair<int, int> kReduced[] = {
+        { 8, cv::IMREAD_REDUCED_COLOR_8 },
+        { 4, cv::IMREAD_REDUCED_COLOR_4 },
+        { 2, cv::IMREAD_REDUCED_COLOR_2 },
+    };
+    for (const auto& [denom, flag] : kReduced) {
+        int reduced_width = (width + denom - 1) / denom;
+        int reduced_height = (height + denom - 1) / denom;
+        if (reduced_width >= target_width && reduced_height >= target_height) {
+            return flag;
+        }
+    }
+    return cv::IMREAD_COLOR;
+}
+
+std::optional<std::pair<int, int>> ScreencapHelper::jpg_size(std::string_view jpg)
+{
+    auto byte = [&](size_t pos) { return static_cast<uint8_t>(jpg[pos]); };
+    auto word = [&](size_t pos) { return (byte(pos) << 8) | byte(pos + 1); };
+
+    if (jpg.size() < 4 || byte(0) != 0xFF || byte(1) != 0xD8) {
+        return std::nullopt;
+    }
+
+    // 逐段跳过，直到 SOFn 段（FFC0 ~ FFCF，除去 C4 DHT、C8 JPG、CC DAC）
+    size_t pos = 2;
+    while (pos + 4 <= jpg.size()) {
+        if (byte(pos) != 0xFF) {
+            return std::nullopt;
+        }
+        uint8_t marker = byte(pos + 1);
+        if (marker == 0xFF) { // 填充字节
+            ++pos;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) { // 无长度段
+            pos += 2;
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) { // EOI / SOS 之后不会再有 SOF
+            return std::nullopt;
+        }
+
+        size_t length = word(pos + 2);
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            // length(2) precision(1) height(2) width(2)
+            if (pos + 9 > jpg.size()) {
+                return std::nullopt;
+            }
+            return std::make_pair(word(pos + 7), word(pos + 5));
+        }
+        pos += 2 + length;
+    }
+    return std::nullopt;
 }
 
 bool ScreencapHelper::clean_cr(std::string& buffer)
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 
 #include "Conf/Conf.h"
+#include "Utils/FramePool.hpp"
 #include "Utils/NoWarningCVMat.hpp"
 
 MAA_CTRL_UNIT_NS_BEGIN
@@ -15,6 +19,7 @@ public:
     void set_wh(int w, int h);
     int get_w() const { return width_; }
     int get_h() const { return height_; }
+    void set_target_size(int w, int h);
 
     std::optional<cv::Mat> process_data(std::string& buffer,
                                         std::function<std::optional<cv::Mat>(const std::string& buffer)> decoder);
@@ -28,8 +33,17 @@ public:
 protected:
     int width_ = 0;
     int height_ = 0;
+    // 可能被 MinicapStream 的解码线程读取
+    std::atomic_int target_width_ = 0;
+    std::atomic_int target_height_ = 0;
 
 private:
+    FramePool frame_pool_;
+    cv::Mat scaled_rgba_;
+
+    int jpg_imread_flag(std::string_view jpg) const;
+    static std::optional<std::pair<int, int>> jpg_size(std::string_view jpg);
+
     enum class EndOfLine
     {
         UnknownYet,
@@ -0,0 +1,192 @@
+#include "VideoStream.h"
+
+#include <string>
+#include <vector>
+
+#include "Utils/Format.hpp"
+#include "Utils/Logger.h"
+
+MAA_CTRL_UNIT_NS_BEGIN
+
+static constexpr unsigned short kStreamPort = 1315;
+static constexpr unsigned kFrameTimeout = 5;
+static constexpr unsigned kStopTimeout = 3;
+
+ScreencapVideoStream::~ScreencapVideoStream()
+{
+    deinit();
+}
+
+bool ScreencapVideoStream::parse(const json::value& config)
+{
+    return parse_argv("ScreencapVideoStream", config, screencap_video_stream_argv_) &&
+           parse_argv("ForwardTcp", config, forward_argv_);
+}
+
+bool ScreencapVideoStream::init(int swidth, int sheight)
+{
+    LogFunc;
+
+    deinit();
+    set_wh(swidth, sheight);
+
+    if (!io_ptr_) {
+        LogError << "io_ptr is nullptr";
+        return false;
+    }
+
+    merge_replacement({ { "{FOWARD_PORT}", std::to_string(kStreamPort) },
+                        { "{REMOTE_PORT}", std::to_string(kStreamPort) } });
+    if (!command(forward_argv_.gen(argv_replace_))) {
+        return false;
+    }
+
+    process_handle_ = io_ptr_->interactive_shell(screencap_video_stream_argv_.gen(argv_replace_));
+    if (!process_handle_) {
+        LogError << "failed to start screenrecord";
+        return false;
+    }
+
+    auto stream = std::make_shared<Stream>();
+    if (!open_stream(stream->capture)) {
+        deinit();
+        return false;
+    }
+
+    stream->running = true;
+    stream_ = stream;
+    decoder_ = std::thread(&ScreencapVideoStream::decoding, std::move(stream), screencap_helper_.get_w(),
+                           screencap_helper_.get_h());
+
+    return true;
+}
+
+void ScreencapVideoStream::deinit()
+{
+    // 结束 screenrecord，socket 通常随之关闭，decoder 线程的阻塞读会返回
+    process_handle_ = nullptr;
+
+    if (!stream_) {
+        return;
+    }
+
+    bool finished = false;
+    {
+        std::unique_lock<std::mutex> lock(stream_->frame_mutex);
+        stream_->running = false;
+        stream_->latest_image = cv::Mat();
+        stream_->frame_cond.notify_all();
+
+        using namespace std::chrono_literals;
+        finished = stream_->frame_cond.wait_for(lock, kStopTimeout * 1s, [&]() { return stream_->finished; });
+    }
+
+    if (decoder_.joinable()) {
+        if (finished) {
+            decoder_.join();
+        }
+        else {
+            // 设备端没有断开连接时读会一直阻塞，不能在这里等它
+            LogWarn << "decoder is still blocked in read, detach it";
+            decoder_.detach();
+        }
+    }
+    stream_ = nullptr;
+}
+
+std::optional<cv::Mat> ScreencapVideoStream::screencap()
+{
+    if (!stream_) {
+        LogError << "stream is not opened";
+        return std::nullopt;
+    }
+
+    std::unique_lock<std::mutex> lock(stream_->frame_mutex);
+
+    // screenrecord 只在画面变化时出帧，所以最新解码的一帧就是当前画面
+    using namespace std::chrono_literals;
+    stream_->frame_cond.wait_for(lock, kFrameTimeout * 1s,
+                                 [&]() { return !stream_->latest_image.empty() || !stream_->running; });
+    if (!stream_->running) {
+        LogError << "stream ended";
+        return std::nullopt;
+    }
+    if (stream_->latest_image.empty()) {
+        LogError << "no frame decoded yet";
+        return std::nullopt;
+    }
+
+    return stream_->latest_image;
+}
+
+bool ScreencapVideoStream::open_stream(cv::VideoCapture& capture)
+{
+    LogFunc;
+
+    auto serial_host = argv_replace_["{ADB_SERIAL}"];
+    auto shp = serial_host.find(':');
+    std::string local = "127.0.0.1";
+    if (shp != std::string::npos) {
+        local = serial_host.substr(0, shp);
+    }
+    std::string url = MAA_FMT::format("tcp://{}:{}", local, kStreamPort);
+
+    // 只设打开超时：画面静止时 screenrecord 不出帧，读超时会被误当成断流
+    const std::vector<int> params = {
+        cv::CAP_PROP_OPEN_TIMEOUT_MSEC,
+        static_cast<int>(kFrameTimeout * 1000),
+    };
+
+    // 设备端 nc 开始监听前，forward 会接受连接后立即断开，所以要重试
+    constexpr int kRetryTimes = 10;
+    for (int i = 0; i != kRetryTimes; ++i) {
+        using namespace std::chrono_literals;
+        std::this_thread::sleep_for(200ms);
+
+        if (capture.open(url, cv::CAP_FFMPEG, params) && capture.isOpened()) {
+            LogInfo << "stream opened" << VAR(url) << VAR(capture.getBackendName());
+            return true;
+        }
+        LogWarn << "open stream failed" << VAR(i) << VAR(url);
+    }
+
+    LogError << "failed to open stream" << VAR(url);
+    return false;
+}
+
+void ScreencapVideoStream::decoding(std::shared_ptr<Stream> stream, int width, int height)
+{
+    LogFunc;
+
+    while (stream->running) {
+        // 尺寸没变时 read 直接写进池里取出的 buffer
+        cv::Mat frame = stream->frame_pool.acquire(height, width, CV_8UC3);
+        if (!stream->capture.read(frame) || frame.empty()) {
+            LogWarn << "stream ended";
+            break;
+        }
+        width = frame.cols;
+        height = frame.rows;
+
+        {
+            std::unique_lock<std::mutex> lock(stream->frame_mutex);
+            if (stream->running) {
+                stream->latest_image = std::move(frame);
+            }
+        }
+        stream->frame_cond.notify_all();
+    }
+
+    stream->capture.release();
+
+    {
+        // 断流后不能再把最后一帧当作当前画面
+        std::unique_lock<std::mutex> lock(stream->frame_mutex);
+        stream->running = false;
+        stream->finished = true;
+        stream->latest_image = cv::Mat();
+    }
+    stream->frame_cond.notify_all();
+}
+
+MAA_CTRL_UNIT_NS_END
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "UnitBase.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "ScreencapHelper.h"
+#include "Utils/FramePool.hpp"
+#include "Utils/NoWarningCV.hpp"
+
+MAA_CTRL_UNIT_NS_BEGIN
+
+// 设备端 screenrecord 持续输出 H.264，经 adb forward 的 socket 交给 videoio 解码，本地只保留最新的一帧
+class ScreencapVideoStream : public ScreencapBase
+{
+public:
+    virtual ~ScreencapVideoStream() override;
+
+public: // from UnitBase
+    virtual bool parse(const json::value& config) override;
+
+public: // from ScreencapAPI
+    virtual bool init(int swidth, int sheight) override;
+    virtual void deinit() override;
+
+    virtual std::optional<cv::Mat> screencap() override;
+
+private:
+    // 解码线程用到的全部状态。capture.read 没有办法打断，deinit 等不到线程退出时只能 detach，
+    // 所以这些状态由线程和本对象共同持有，不会随本对象析构
+    struct Stream
+    {
+        cv::VideoCapture capture;
+        std::atomic_bool running = false;
+        bool finished = false;
+
+        // 解码出的帧放在池里的 buffer 中，已经交出去的帧不会被改写
+        FramePool frame_pool;
+        std::mutex frame_mutex;
+        std::condition_variable frame_cond;
+        cv::Mat latest_image;
+    };
+
+    bool open_stream(cv::VideoCapture& capture);
+    static void decoding(std::shared_ptr<Stream> stream, int width, int height);
+
+    Argv screencap_video_stream_argv_;
+    Argv forward_argv_;
+
+    std::shared_ptr<IOHandler> process_handle_;
+    std::shared_ptr<Stream> stream_;
+    std::thread decoder_;
+};
+
+MAA_CTRL_UNIT_NS_END
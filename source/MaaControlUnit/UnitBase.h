@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+
 #include <meojson/json.hpp>
 
 #include "MaaControlUnit/ControlUnitAPI.h"
@@ -58,7 +61,12 @@ public:
     virtual ~ScreencapBase() override = default;
 
 public:
+    virtual bool prepare() override { return true; }
     virtual void set_wh(int swidth, int sheight) override { screencap_helper_.set_wh(swidth, sheight); }
+    virtual void set_target_size(int twidth, int theight) override
+    {
+        screencap_helper_.set_target_size(twidth, theight);
+    }
 
 protected:
     ScreencapHelper screencap_helper_;
@@ -68,6 +76,13 @@ class TouchInputBase : public TouchInputAPI, virtual public UnitBase
 {
 public:
     virtual ~TouchInputBase() override = default;
+
+public:
+    virtual std::chrono::steady_clock::time_point gesture_end() const override { return gesture_end_; }
+
+protected:
+    // 控制器等待输入完成时会从别的线程读
+    std::atomic<std::chrono::steady_clock::time_point> gesture_end_;
 };
 
 class KeyInputBase : public KeyInputAPI, virtual public UnitBase
@@ -133,7 +133,21 @@ MaaControllerHandle MaaCustomControllerCreate(MaaCustomControllerHandle handle,
         return nullptr;
     }
 
-    return new MAA_CTRL_NS::CustomController(handle, callback, callback_arg);
+    return new MAA_CTRL_NS::CustomController(handle, nullptr, callback, callback_arg);
+}
+
+MaaControllerHandle MaaCustomControllerCreateWithRawImage(MaaCustomControllerHandle handle,
+                                                          MaaCustomControllerRawImageHandle raw_image_handle,
+                                                          MaaControllerCallback callback,
+                                                          MaaCallbackTransparentArg callback_arg)
+{
+    LogFunc << VAR(handle) << VAR(raw_image_handle) << VAR_VOIDP(callback) << VAR_VOIDP(callback_arg);
+
+    if (!handle) {
+        return nullptr;
+    }
+
+    return new MAA_CTRL_NS::CustomController(handle, raw_image_handle, callback, callback_arg);
 }
 
 MaaControllerHandle MaaThriftControllerCreate(MaaString param, MaaControllerCallback callback,
@@ -290,6 +304,61 @@ MaaSize MaaControllerGetUUID(MaaControllerHandle ctrl, char* buff, MaaSize buff_
     return size;
 }
 
+MaaSize MaaControllerGetImageEncoded(MaaControllerHandle ctrl, MaaImageEncoding encoding, void* buff,
+                                     MaaSize buff_size)
+{
+    LogFunc << VAR_VOIDP(ctrl) << VAR(encoding) << VAR_VOIDP(buff) << VAR(buff_size);
+
+    if (!ctrl) {
+        return MaaNullSize;
+    }
+    auto image = ctrl->get_image_encoded(encoding);
+    if (!image || image->empty()) {
+        return MaaNullSize;
+    }
+    size_t size = image->size();
+    if (!buff) {
+        return size;
+    }
+    if (size > buff_size) {
+        return MaaNullSize;
+    }
+    memcpy(buff, image->data(), size);
+    return size;
+}
+
+MaaSize MaaControllerGetImageRaw(MaaControllerHandle ctrl, int32_t* width, int32_t* height, MaaImageFormat* format,
+                                 void* buff, MaaSize buff_size)
+{
+    LogFunc << VAR_VOIDP(ctrl) << VAR_VOIDP(buff) << VAR(buff_size);
+
+    if (!ctrl || !width || !height || !format) {
+        return MaaNullSize;
+    }
+    cv::Mat image = ctrl->get_image_raw();
+    if (image.empty()) {
+        return MaaNullSize;
+    }
+    *width = image.cols;
+    *height = image.rows;
+    *format = MaaImageFormat_BGR;
+
+    // 截图可能是池里 buffer 的一部分，行之间不连续
+    size_t row_size = image.cols * image.elemSize();
+    size_t size = row_size * image.rows;
+    if (!buff) {
+        return size;
+    }
+    if (size > buff_size) {
+        return MaaNullSize;
+    }
+    auto* dst = static_cast<uint8_t*>(buff);
+    for (int r = 0; r < image.rows; ++r) {
+        memcpy(dst + r * row_size, image.ptr(r), row_size);
+    }
+    return size;
+}
+
 MaaInstanceHandle MaaCreate(MaaInstanceCallback callback, MaaCallbackTransparentArg callback_arg)
 {
     LogFunc << VAR_VOIDP(callback) << VAR_VOIDP(callback_arg);
@@ -353,7 +422,19 @@ MaaBool MaaRegisterCustomRecognizer(MaaInstanceHandle inst, MaaString name, MaaC
         return false;
     }
 
-    return inst->register_custom_recognizer(name, recognizer);
+    return inst->register_custom_recognizer(name, recognizer, 0);
+}
+
+MaaBool MaaRegisterCustomRecognizerWithDetailSize(MaaInstanceHandle inst, MaaString name,
+                                                  MaaCustomRecognizerHandle recognizer, MaaSize detail_buff_size)
+{
+    LogFunc << VAR_VOIDP(inst) << VAR(name) << VAR_VOIDP(recognizer) << VAR(detail_buff_size);
+
+    if (!inst) {
+        return false;
+    }
+
+    return inst->register_custom_recognizer(name, recognizer, detail_buff_size);
 }
 
 MaaBool MaaUnregisterCustomRecognizer(MaaInstanceHandle inst, MaaString name)
@@ -542,6 +623,32 @@ MaaSize MaaSyncContextScreencap(MaaSyncContextHandle sync_context, void* buff, M
     return data.size();
 }
 
+MaaSize MaaSyncContextScreencapEncoded(MaaSyncContextHandle sync_context, MaaImageEncoding encoding, void* buff,
+                                       MaaSize buff_size)
+{
+    LogFunc << VAR_VOIDP(sync_context) << VAR(encoding) << VAR(buff) << VAR(buff_size);
+    if (!sync_context) {
+        return MaaNullSize;
+    }
+    if (!buff && !sync_context->capture()) {
+        return MaaNullSize;
+    }
+    return MaaControllerGetImageEncoded(sync_context->controller(), encoding, buff, buff_size);
+}
+
+MaaSize MaaSyncContextScreencapRaw(MaaSyncContextHandle sync_context, int32_t* width, int32_t* height,
+                                   MaaImageFormat* format, void* buff, MaaSize buff_size)
+{
+    LogFunc << VAR_VOIDP(sync_context) << VAR(buff) << VAR(buff_size);
+    if (!sync_context) {
+        return MaaNullSize;
+    }
+    if (!buff && !sync_context->capture()) {
+        return MaaNullSize;
+    }
+    return MaaControllerGetImageRaw(sync_context->controller(), width, height, format, buff, buff_size);
+}
+
 MaaSize MaaSyncContextGetTaskResult(MaaSyncContextHandle sync_context, MaaString task, char* buff, MaaSize buff_size)
 {
     LogFunc << VAR_VOIDP(sync_context) << VAR(task) << VAR(buff) << VAR(buff_size);
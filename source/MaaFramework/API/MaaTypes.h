@@ -2,8 +2,10 @@
 
 #include "Conf/Conf.h"
 #include "MaaFramework/MaaDef.h"
+#include "Utils/NoWarningCVMat.hpp"
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -47,6 +49,10 @@ public:
     virtual MaaBool connected() const = 0;
 
     virtual std::vector<uint8_t> get_image_cache() const = 0;
+    // 编码结果按帧缓存
+    virtual std::shared_ptr<const std::vector<uint8_t>> get_image_encoded(MaaImageEncoding encoding) const = 0;
+    // BGR，与控制器共享内存，只读
+    virtual cv::Mat get_image_raw() const = 0;
 
     virtual std::string get_uuid() const = 0;
 };
@@ -65,7 +71,8 @@ public:
     virtual MaaTaskId post_task(std::string entry, std::string_view param) = 0;
     virtual bool set_task_param(MaaTaskId task_id, std::string_view param) = 0;
 
-    virtual bool register_custom_recognizer(std::string name, MaaCustomRecognizerHandle handle) = 0;
+    virtual bool register_custom_recognizer(std::string name, MaaCustomRecognizerHandle handle,
+                                            MaaSize detail_buff_size) = 0;
     virtual bool unregister_custom_recognizer(std::string name) = 0;
     virtual void clear_custom_recognizer() = 0;
     virtual bool register_custom_action(std::string name, MaaCustomActionHandle handle) = 0;
@@ -92,6 +99,8 @@ public:
     virtual void click(int x, int y) = 0;
     virtual void swipe(std::vector<int> x_steps, std::vector<int> y_steps, std::vector<int> step_delay) = 0;
     virtual std::vector<uint8_t> screencap() = 0;
+    // 截图并等待完成，图从 controller 取
+    virtual bool capture() = 0;
 
     virtual std::string task_result(const std::string& task_name) const = 0;
 
@@ -1,9 +1,12 @@
 #include "AdbController.h"
 
 #include "MaaFramework/MaaMsg.h"
+#include "Utils/InitScheduler.hpp"
 #include "Utils/Logger.h"
 #include "Utils/StringMisc.hpp"
 
+#include <thread>
+
 #include <meojson/json.hpp>
 
 MAA_CTRL_NS_BEGIN
@@ -59,14 +62,45 @@ bool AdbController::_connect()
         { "address", address_ },
     };
 
-    bool connected = unit_mgr_->connection_obj()->connect();
-    if (!connected) {
+    // uuid 和分辨率、截图和触控的初始化互不依赖，同时进行；截图测速会被其他初始化拖慢，等它们都做完再测。
+    // 通知仍按原来的顺序发
+    auto connect = [this]() { return unit_mgr_->connection_obj()->connect(); };
+    auto request_uuid = [this]() { return unit_mgr_->device_info_obj()->request_uuid().has_value(); };
+    auto request_resolution = [this]() { return unit_mgr_->device_info_obj()->request_resolution().has_value(); };
+    auto init_screencap = [this]() {
+        auto [width, height] = unit_mgr_->device_info_obj()->get_resolution();
+        return unit_mgr_->screencap_obj()->init(width, height);
+    };
+    auto prepare_screencap = [this]() { return unit_mgr_->screencap_obj()->prepare(); };
+    auto init_touch_input = [this]() {
+        auto [width, height] = unit_mgr_->device_info_obj()->get_resolution();
+        return unit_mgr_->touch_input_obj()->init(width, height);
+    };
+
+    InitScheduler scheduler;
+    scheduler.add("Connect", connect);
+    scheduler.add("UUID", request_uuid, { "Connect" });
+    scheduler.add("Resolution", request_resolution, { "Connect" });
+    scheduler.add("ScreencapInit", init_screencap, { "Resolution" });
+    scheduler.add("TouchInputInit", init_touch_input, { "Resolution" });
+    scheduler.add("ScreencapPrepare", prepare_screencap, { "UUID", "ScreencapInit", "TouchInputInit" });
+    scheduler.run();
+
+    json::object cost { { "Total", scheduler.total().count() } };
+    for (const auto& step : scheduler.report()) {
+        if (step.executed) {
+            cost[step.name] = step.cost.count();
+        }
+    }
+    details |= { { "cost", cost } };
+
+    if (!scheduler.succeeded("Connect")) {
         notifier.notify(MaaMsg_Controller_ConnectFailed, details | json::object { { "why", "ConnectFailed" } });
         LogError << "failed to connect";
         return false;
     }
 
-    if (!unit_mgr_->device_info_obj()->request_uuid()) {
+    if (!scheduler.succeeded("UUID")) {
         notifier.notify(MaaMsg_Controller_UUIDGetFailed, details);
         notifier.notify(MaaMsg_Controller_ConnectFailed, details | json::object { { "why", "UUIDGetFailed" } });
         LogError << "failed to request_uuid";
@@ -77,7 +111,7 @@ bool AdbController::_connect()
 
     notifier.notify(MaaMsg_Controller_UUIDGot, details | json::object { { "uuid", uuid } });
 
-    if (!unit_mgr_->device_info_obj()->request_resolution()) {
+    if (!scheduler.succeeded("Resolution")) {
         notifier.notify(MaaMsg_Controller_ResolutionGetFailed, details);
         notifier.notify(MaaMsg_Controller_ConnectFailed, details | json::object { { "why", "ResolutionGetFailed" } });
         LogError << "failed to request_resolution";
@@ -89,7 +123,10 @@ bool AdbController::_connect()
 
     notifier.notify(MaaMsg_Controller_ResolutionGot, details);
 
-    if (!unit_mgr_->screencap_obj()->init(w, h)) {
+    // 触控初始化失败时测速没有执行，这种情况在下面按触控失败报
+    bool screencap_ok = scheduler.succeeded("ScreencapInit") &&
+                        (scheduler.succeeded("ScreencapPrepare") || !scheduler.succeeded("TouchInputInit"));
+    if (!screencap_ok) {
         notifier.notify(MaaMsg_Controller_ScreencapInitFailed, details);
         notifier.notify(MaaMsg_Controller_ConnectFailed, details | json::object { { "why", "ScreencapInitFailed" } });
         LogError << "failed to init screencap";
@@ -97,7 +134,7 @@ bool AdbController::_connect()
     }
     notifier.notify(MaaMsg_Controller_ScreencapInited, details);
 
-    if (!unit_mgr_->touch_input_obj()->init(w, h)) {
+    if (!scheduler.succeeded("TouchInputInit")) {
         notifier.notify(MaaMsg_Controller_TouchInputInitFailed, details);
         notifier.notify(MaaMsg_Controller_ConnectFailed, details | json::object { { "why", "TouchInputInitFailed" } });
         LogError << "failed to init touch_input";
@@ -155,6 +192,9 @@ void AdbController::_press_key(PressKeyParam param)
         return;
     }
 
+    // 按键和触控可能不是同一个通道，得等之前的手势做完
+    wait_gesture();
+
     bool ret = unit_mgr_->key_input_obj()->press_key(param.keycode);
 
     if (!ret) {
@@ -169,6 +209,8 @@ cv::Mat AdbController::_screencap()
         return {};
     }
 
+    wait_gesture();
+
     auto ret = unit_mgr_->screencap_obj()->screencap();
     if (!ret) {
         return cv::Mat();
@@ -176,6 +218,16 @@ cv::Mat AdbController::_screencap()
     return std::move(ret.value());
 }
 
+void AdbController::_set_target_image_size(int width, int height)
+{
+    if (!unit_mgr_ || !unit_mgr_->screencap_obj()) {
+        LogError << "unit is nullptr" << VAR(unit_mgr_) << VAR(unit_mgr_->screencap_obj());
+        return;
+    }
+
+    unit_mgr_->screencap_obj()->set_target_size(width, height);
+}
+
 bool AdbController::_start_app(AppParam param)
 {
     if (!unit_mgr_ || !unit_mgr_->activity_obj()) {
@@ -196,6 +248,19 @@ bool AdbController::_stop_app(AppParam param)
     return unit_mgr_->activity_obj()->stop(param.package) && reinit_resolution();
 }
 
+void AdbController::wait_gesture()
+{
+    if (!unit_mgr_ || !unit_mgr_->touch_input_obj()) {
+        return;
+    }
+
+    auto gesture_end = unit_mgr_->touch_input_obj()->gesture_end();
+    if (gesture_end > std::chrono::steady_clock::now()) {
+        LogTrace << "wait for gesture";
+        std::this_thread::sleep_until(gesture_end);
+    }
+}
+
 bool AdbController::reinit_resolution()
 {
     LogFunc;
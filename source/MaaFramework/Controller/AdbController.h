@@ -23,11 +23,14 @@ protected:
     virtual void _swipe(SwipeParam param) override;
     virtual void _press_key(PressKeyParam param) override;
     virtual cv::Mat _screencap() override;
+    virtual void _set_target_image_size(int width, int height) override;
     virtual bool _start_app(AppParam param) override;
     virtual bool _stop_app(AppParam param) override;
+    virtual void _wait_inputs() override { wait_gesture(); }
 
 private:
     bool reinit_resolution();
+    void wait_gesture();
 
     std::string adb_path_;
     std::string address_;
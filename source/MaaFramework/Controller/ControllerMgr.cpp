@@ -4,7 +4,10 @@
 #include "Resource/ResourceMgr.h"
 #include "Utils/Math.hpp"
 #include "Utils/NoWarningCV.hpp"
+#include "Utils/Qoi.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <tuple>
 
 MAA_CTRL_NS_BEGIN
@@ -44,6 +47,9 @@ bool ControllerMgr::set_option(MaaCtrlOption key, MaaOptionValue value, MaaOptio
     case MaaCtrlOption_DefaultAppPackage:
         return set_default_app_package(value, val_size);
 
+    case MaaCtrlOption_ScreenshotMaxFrameAge:
+        return set_screenshot_max_frame_age(value, val_size);
+
     default:
         LogError << "Unknown key" << VAR(key) << VAR(value);
         return false;
@@ -52,7 +58,7 @@ bool ControllerMgr::set_option(MaaCtrlOption key, MaaOptionValue value, MaaOptio
 
 MaaCtrlId ControllerMgr::post_connection()
 {
-    auto id = action_runner_->post({ .type = Action::Type::connect });
+    auto id = post_action({ .type = Action::Type::connect });
     std::unique_lock lock { post_ids_mutex_ };
     post_ids_.emplace(id);
     return id;
@@ -62,7 +68,7 @@ MaaCtrlId ControllerMgr::post_click(int x, int y)
 {
     auto [xx, yy] = preproc_touch_coord(x, y);
     ClickParam param { .x = xx, .y = yy };
-    auto id = action_runner_->post({ .type = Action::Type::click, .param = std::move(param) });
+    auto id = post_action({ .type = Action::Type::click, .param = std::move(param) });
     std::unique_lock lock { post_ids_mutex_ };
     post_ids_.emplace(id);
     return id;
@@ -81,7 +87,7 @@ MaaCtrlId ControllerMgr::post_swipe(std::vector<int> x_steps, std::vector<int> y
         param.steps.emplace_back(std::move(step));
     }
 
-    auto id = action_runner_->post({ .type = Action::Type::swipe, .param = std::move(param) });
+    auto id = post_action({ .type = Action::Type::swipe, .param = std::move(param) });
     std::unique_lock lock { post_ids_mutex_ };
     post_ids_.emplace(id);
     return id;
@@ -89,9 +95,12 @@ MaaCtrlId ControllerMgr::post_swipe(std::vector<int> x_steps, std::vector<int> y
 
 MaaCtrlId ControllerMgr::post_screencap()
 {
-    auto id = action_runner_->post({ .type = Action::Type::screencap });
-    std::unique_lock lock { post_ids_mutex_ };
-    post_ids_.emplace(id);
+    auto id = request_screencap();
+    // 合并到了已经开始的截图上时，开始的通知已经发过了
+    if (action_runner_->status(id) == MaaStatus_Pending) {
+        std::unique_lock lock { post_ids_mutex_ };
+        post_ids_.emplace(id);
+    }
     return id;
 }
 
@@ -119,13 +128,52 @@ MaaBool ControllerMgr::connected() const
     return connected_;
 }
 
-std::vector<uint8_t> ControllerMgr::get_image_cache() const
+std::shared_ptr<const std::vector<uint8_t>> Frame::encoded(MaaImageEncoding encoding) const
 {
-    std::vector<uint8_t> buff;
-    cv::imencode(".png", image_, buff);
+    std::unique_lock lock { encoded_mutex_ };
+
+    if (auto it = encoded_.find(encoding); it != encoded_.end()) {
+        return it->second;
+    }
+
+    auto buff = std::make_shared<std::vector<uint8_t>>();
+    switch (encoding) {
+    case MaaImageEncoding_PNG:
+        cv::imencode(".png", image, *buff);
+        break;
+    case MaaImageEncoding_QOI:
+        *buff = encode_qoi(image);
+        break;
+    default:
+        LogError << "Unknown encoding" << VAR(encoding);
+        return nullptr;
+    }
+
+    encoded_.emplace(encoding, buff);
     return buff;
 }
 
+std::vector<uint8_t> ControllerMgr::get_image_cache() const
+{
+    auto buff = get_image_encoded(MaaImageEncoding_PNG);
+    return buff ? *buff : std::vector<uint8_t>();
+}
+
+std::shared_ptr<const std::vector<uint8_t>> ControllerMgr::get_image_encoded(MaaImageEncoding encoding) const
+{
+    auto frame = latest_frame();
+    if (!frame) {
+        return nullptr;
+    }
+    return frame->encoded(encoding);
+}
+
+cv::Mat ControllerMgr::get_image_raw() const
+{
+    auto frame = latest_frame();
+    return frame ? frame->image : cv::Mat();
+}
+
 void ControllerMgr::on_stop()
 {
     action_runner_->release();
@@ -140,7 +188,7 @@ void ControllerMgr::click(const cv::Point& p)
 {
     auto [x, y] = preproc_touch_coord(p.x, p.y);
     ClickParam param { .x = x, .y = y };
-    action_runner_->post({ .type = Action::Type::click, .param = std::move(param) }, true);
+    post_action({ .type = Action::Type::click, .param = std::move(param) });
 }
 
 void ControllerMgr::swipe(const cv::Rect& r1, const cv::Rect& r2, int duration)
@@ -163,19 +211,30 @@ void ControllerMgr::swipe(const cv::Point& p1, const cv::Point& p2, int duration
         int y = static_cast<int>(round(std::lerp(y1, y2, progress)));
         param.steps.emplace_back(SwipeParam::Step { .x = x, .y = y, .delay = SampleDelay });
     }
-    action_runner_->post({ .type = Action::Type::swipe, .param = std::move(param) }, true);
+    post_action({ .type = Action::Type::swipe, .param = std::move(param) });
 }
 
 void ControllerMgr::press_key(int keycode)
 {
-    action_runner_->post({ .type = Action::Type::press_key, .param = PressKeyParam { .keycode = keycode } }, true);
+    post_action({ .type = Action::Type::press_key, .param = PressKeyParam { .keycode = keycode } });
 }
 
 cv::Mat ControllerMgr::screencap()
 {
-    std::unique_lock<std::mutex> lock(image_mutex_);
-    action_runner_->post({ .type = Action::Type::screencap }, true);
-    return image_.clone();
+    auto frame = screencap_frame();
+    return frame ? frame->image : cv::Mat();
+}
+
+FramePtr ControllerMgr::screencap_frame()
+{
+    auto id = request_screencap();
+    action_runner_->wait(id);
+    return latest_frame();
+}
+
+FramePtr ControllerMgr::latest_frame() const
+{
+    return latest_frame_.load();
 }
 
 void ControllerMgr::start_app()
@@ -198,12 +257,94 @@ void ControllerMgr::stop_app()
 
 void ControllerMgr::start_app(const std::string& package)
 {
-    action_runner_->post({ .type = Action::Type::start_app, .param = AppParam { .package = package } }, true);
+    post_action({ .type = Action::Type::start_app, .param = AppParam { .package = package } });
 }
 
 void ControllerMgr::stop_app(const std::string& package)
 {
-    action_runner_->post({ .type = Action::Type::stop_app, .param = AppParam { .package = package } }, true);
+    post_action({ .type = Action::Type::stop_app, .param = AppParam { .package = package } });
+}
+
+void ControllerMgr::wait_actions()
+{
+    action_runner_->wait(last_action_id_);
+    _wait_inputs();
+}
+
+AsyncRunner<Action>::Id ControllerMgr::post_action(Action action, bool block)
+{
+    AsyncRunner<Action>::Id id = MaaInvalidId;
+    {
+        std::unique_lock lock { screencap_mutex_ };
+        // 之后的截图请求都不能再合并到这之前的截图上
+        ++frame_epoch_;
+        pending_screencap_ = {};
+        id = action_runner_->post(std::move(action));
+        last_action_id_ = id;
+    }
+
+    if (block) {
+        action_runner_->wait(id);
+    }
+    return id;
+}
+
+AsyncRunner<Action>::Id ControllerMgr::request_screencap()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::milliseconds max_age(screenshot_max_frame_age_);
+
+    std::unique_lock lock { screencap_mutex_ };
+
+    // 排队中的截图一定在最后一个操作之后，直接等它
+    if (pending_screencap_.id != MaaInvalidId) {
+        return pending_screencap_.id;
+    }
+
+    // 正在进行的截图之后没有新的操作，且开始得足够晚
+    if (running_screencap_.id != MaaInvalidId && running_screencap_.epoch == frame_epoch_ &&
+        now - running_screencap_start_ <= max_age) {
+        return running_screencap_.id;
+    }
+
+    // 已有的帧还足够新
+    if (latest_screencap_.id != MaaInvalidId && latest_screencap_.epoch == frame_epoch_) {
+        auto frame = latest_frame();
+        if (frame && now - frame->timestamp <= max_age) {
+            return latest_screencap_.id;
+        }
+    }
+
+    pending_screencap_.id = action_runner_->post({ .type = Action::Type::screencap });
+    pending_screencap_.epoch = frame_epoch_;
+    return pending_screencap_.id;
+}
+
+bool ControllerMgr::run_screencap(typename AsyncRunner<Action>::Id id)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::unique_lock lock { screencap_mutex_ };
+        if (pending_screencap_.id == id) {
+            running_screencap_ = pending_screencap_;
+            pending_screencap_ = {};
+        }
+        else {
+            // 排队时已被后来的操作作废（frame_epoch_ 至少自增过一次），仍然截，但不再接受合并
+            running_screencap_ = { .id = id, .epoch = frame_epoch_ - 1 };
+        }
+        running_screencap_start_ = start;
+    }
+
+    _set_target_image_size(image_target_width_, image_target_height_);
+    bool ret = postproc_screenshot(start, _screencap());
+
+    std::unique_lock lock { screencap_mutex_ };
+    if (ret) {
+        latest_screencap_ = running_screencap_;
+    }
+    running_screencap_ = {};
+    return ret;
 }
 
 cv::Point ControllerMgr::rand_point(const cv::Rect& r)
@@ -261,6 +402,8 @@ bool ControllerMgr::run_action(typename AsyncRunner<Action>::Id id, Action actio
         break;
     case Action::Type::swipe:
         _swipe(std::get<SwipeParam>(action.param));
+        // 触控单元写完整段手势就返回了；等设备上划完再算这个 id 完成，wait 到的 swipe 才是真的做完了
+        _wait_inputs();
         ret = true;
         break;
     case Action::Type::press_key:
@@ -269,7 +412,7 @@ bool ControllerMgr::run_action(typename AsyncRunner<Action>::Id id, Action actio
         break;
 
     case Action::Type::screencap:
-        ret = postproc_screenshot(_screencap());
+        ret = run_screencap(id);
         break;
 
     case Action::Type::start_app:
@@ -312,25 +455,51 @@ std::pair<int, int> ControllerMgr::preproc_touch_coord(int x, int y)
     return { proced_x, proced_y };
 }
 
-bool ControllerMgr::postproc_screenshot(const cv::Mat& raw)
+bool ControllerMgr::postproc_screenshot(std::chrono::steady_clock::time_point timestamp, const cv::Mat& raw)
 {
     if (raw.empty()) {
         LogError << "Empty screenshot";
         return false;
     }
 
+    if (!check_and_calc_target_image_size(raw)) {
+        LogError << "Invalid target image size";
+        return false;
+    }
+
+    // 截图单元可能已经直接给出了目标尺寸的图
+    bool is_target_size = raw.cols == image_target_width_ && raw.rows == image_target_height_;
+
+    // 截图单元也可能有意缩小过（如 JPEG 的 DCT 缩放解码、minicap 的投影尺寸），只要宽高比与设备一致、
+    // 不小于目标尺寸就是正常的；DCT 缩放时边长向上取整，允许差一个像素
     auto [res_w, res_h] = _get_resolution();
-    if (raw.cols != res_w || raw.rows != res_h) {
+    bool is_device_size = raw.cols == res_w && raw.rows == res_h;
+    bool is_scaled = raw.cols >= image_target_width_ && raw.rows >= image_target_height_ &&
+                     std::abs(static_cast<int64_t>(raw.cols) * res_h - static_cast<int64_t>(raw.rows) * res_w) <=
+                         std::max(res_w, res_h);
+    if (!is_target_size && !is_device_size && !is_scaled) {
         LogWarn << "Invalid resolution" << VAR(raw.cols) << VAR(raw.rows) << VAR(res_w) << VAR(res_h);
     }
 
-    if (!check_and_calc_target_image_size(raw)) {
-        LogError << "Invalid target image size";
+    // 之前发布的帧可能还被引用着，不能原地改写，缩放到池里新取的 buffer
+    cv::Mat image;
+    if (is_target_size) {
+        image = raw;
+    }
+    else {
+        image = frame_pool_.acquire(image_target_height_, image_target_width_, raw.type());
+        cv::resize(raw, image, { image_target_width_, image_target_height_ });
+    }
+    if (image.empty()) {
         return false;
     }
 
-    cv::resize(raw, image_, { image_target_width_, image_target_height_ });
-    return !image_.empty();
+    auto frame = std::make_shared<Frame>();
+    frame->id = ++frame_id_;
+    frame->timestamp = timestamp;
+    frame->image = std::move(image);
+    latest_frame_.store(std::move(frame));
+    return true;
 }
 
 bool ControllerMgr::check_and_calc_target_image_size(const cv::Mat& raw)
@@ -381,6 +550,10 @@ void ControllerMgr::clear_target_image_size()
 {
     image_target_width_ = 0;
     image_target_height_ = 0;
+
+    // 旧尺寸的帧不能再复用
+    std::unique_lock lock { screencap_mutex_ };
+    ++frame_epoch_;
 }
 
 bool ControllerMgr::set_image_target_long_side(MaaOptionValue value, MaaOptionValueSize val_size)
@@ -427,6 +600,23 @@ bool ControllerMgr::set_default_app_package(MaaOptionValue value, MaaOptionValue
     return true;
 }
 
+bool ControllerMgr::set_screenshot_max_frame_age(MaaOptionValue value, MaaOptionValueSize val_size)
+{
+    if (val_size != sizeof(int)) {
+        LogError << "invalid value size: " << val_size;
+        return false;
+    }
+    int age = *reinterpret_cast<int*>(value);
+    if (age < 0) {
+        LogError << "invalid max frame age: " << age;
+        return false;
+    }
+    screenshot_max_frame_age_ = age;
+
+    LogInfo << "screenshot_max_frame_age_ = " << age;
+    return true;
+}
+
 std::ostream& operator<<(std::ostream& os, const SwipeParam::Step& step)
 {
     os << VAR_RAW(step.x) << VAR_RAW(step.y) << VAR_RAW(step.delay);
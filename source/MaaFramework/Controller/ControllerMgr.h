@@ -4,8 +4,13 @@
 #include "Base/AsyncRunner.hpp"
 #include "Base/MessageNotifier.hpp"
 #include "Instance/InstanceInternalAPI.hpp"
+#include "Utils/AtomicSharedPtr.hpp"
+#include "Utils/FramePool.hpp"
 #include "Utils/NoWarningCVMat.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <random>
@@ -64,6 +69,24 @@ struct Action
 
 std::ostream& operator<<(std::ostream& os, const Action& action);
 
+// 控制器发布的截图，发布后不再修改，多个使用方共享同一帧
+struct Frame
+{
+    // 单调递增
+    uint64_t id = 0;
+    // 开始截图的时间
+    std::chrono::steady_clock::time_point timestamp;
+    cv::Mat image;
+
+    // 帧发布后不再改变，编码一次就够了
+    std::shared_ptr<const std::vector<uint8_t>> encoded(MaaImageEncoding encoding) const;
+
+private:
+    mutable std::mutex encoded_mutex_;
+    mutable std::map<MaaImageEncoding, std::shared_ptr<const std::vector<uint8_t>>> encoded_;
+};
+using FramePtr = std::shared_ptr<const Frame>;
+
 class ControllerMgr : public MaaControllerAPI
 {
 public:
@@ -84,22 +107,31 @@ public:
     virtual MaaBool connected() const override;
 
     virtual std::vector<uint8_t> get_image_cache() const override;
+    virtual std::shared_ptr<const std::vector<uint8_t>> get_image_encoded(MaaImageEncoding encoding) const override;
+    virtual cv::Mat get_image_raw() const override;
     virtual std::string get_uuid() const override = 0;
 
     virtual void on_stop() override;
 
 public:
+    // 输入类操作只投递不等待，之后的截图在队列里排在它们后面，自然能看到操作后的画面
     void click(const cv::Rect& r);
     void click(const cv::Point& p);
     void swipe(const cv::Rect& r1, const cv::Rect& r2, int duration);
     void swipe(const cv::Point& p1, const cv::Point& p2, int duration);
     void press_key(int keycode);
+    // 返回的图像与控制器共享内存，只读
     cv::Mat screencap();
+    FramePtr screencap_frame();
+    // 最近一次发布的帧，不截图，也不等 action 队列
+    FramePtr latest_frame() const;
 
     void start_app();
     void stop_app();
     void start_app(const std::string& package);
     void stop_app(const std::string& package);
+    // 等之前投递的操作都执行完，包括已整段交给设备端的手势
+    void wait_actions();
 
 protected:
     virtual bool _connect() = 0;
@@ -108,8 +140,15 @@ protected:
     virtual void _swipe(SwipeParam param) = 0;
     virtual void _press_key(PressKeyParam param) = 0;
     virtual cv::Mat _screencap() = 0;
+    // 截图前告知当前的目标尺寸（未计算时为 0），便于底层直接解码到接近的尺寸
+    virtual void _set_target_image_size(int /*width*/, int /*height*/) {}
     virtual bool _start_app(AppParam param) = 0;
     virtual bool _stop_app(AppParam param) = 0;
+    // 操作在队列里执行完时设备端可能还没做完（比如整段下发的手势），需要的话在这里等
+    virtual void _wait_inputs() {}
+
+    // 截图用的 buffer 从帧池里取，外部不再引用后会被复用
+    cv::Mat acquire_frame_buffer(int rows, int cols, int type) { return frame_pool_.acquire(rows, cols, type); }
 
 protected:
     MessageNotifier<MaaControllerCallback> notifier;
@@ -118,8 +157,11 @@ private:
     static cv::Point rand_point(const cv::Rect& r);
 
     bool run_action(typename AsyncRunner<Action>::Id id, Action action);
+    AsyncRunner<Action>::Id post_action(Action action, bool block = false);
+    AsyncRunner<Action>::Id request_screencap();
+    bool run_screencap(typename AsyncRunner<Action>::Id id);
     std::pair<int, int> preproc_touch_coord(int x, int y);
-    bool postproc_screenshot(const cv::Mat& raw);
+    bool postproc_screenshot(std::chrono::steady_clock::time_point timestamp, const cv::Mat& raw);
     bool check_and_calc_target_image_size(const cv::Mat& raw);
     void clear_target_image_size();
 
@@ -128,6 +170,7 @@ private: // options
     bool set_image_target_short_side(MaaOptionValue value, MaaOptionValueSize val_size);
     bool set_default_app_package_entry(MaaOptionValue value, MaaOptionValueSize val_size);
     bool set_default_app_package(MaaOptionValue value, MaaOptionValueSize val_size);
+    bool set_screenshot_max_frame_age(MaaOptionValue value, MaaOptionValueSize val_size);
 
 private:
     // InstanceInternalAPI* inst_ = nullptr;
@@ -136,8 +179,23 @@ private:
     static std::minstd_rand rand_engine_;
 
     bool connected_ = false;
-    std::mutex image_mutex_;
-    cv::Mat image_;
+    uint64_t frame_id_ = 0; // 只在 action 线程中修改
+    AtomicSharedPtr<const Frame> latest_frame_;
+    FramePool frame_pool_;
+
+    // 截图请求合并：epoch 在每次投递其他操作时自增，只有同一 epoch 内的截图请求可以共用一帧
+    struct ScreencapRequest
+    {
+        AsyncRunner<Action>::Id id = MaaInvalidId;
+        uint64_t epoch = 0;
+    };
+    std::mutex screencap_mutex_;
+    uint64_t frame_epoch_ = 0;
+    ScreencapRequest pending_screencap_;
+    ScreencapRequest running_screencap_;
+    std::chrono::steady_clock::time_point running_screencap_start_;
+    ScreencapRequest latest_screencap_;
+    std::atomic_int screenshot_max_frame_age_ = 0; // ms
 
     int image_target_long_side_ = 0;
     int image_target_short_side_ = 720;
@@ -147,6 +205,9 @@ private:
     std::string default_app_package_entry_;
     std::string default_app_package_;
 
+    // 最后一个非截图操作，wait_actions 等它
+    std::atomic<AsyncRunner<Action>::Id> last_action_id_ = MaaInvalidId;
+
     std::set<AsyncRunner<Action>::Id> post_ids_;
     std::mutex post_ids_mutex_;
     std::unique_ptr<AsyncRunner<Action>> action_runner_ = nullptr;
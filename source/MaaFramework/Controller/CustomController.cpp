@@ -5,9 +5,10 @@
 
 MAA_CTRL_NS_BEGIN
 
-CustomController::CustomController(MaaCustomControllerHandle handle, MaaControllerCallback callback,
+CustomController::CustomController(MaaCustomControllerHandle handle,
+                                   MaaCustomControllerRawImageHandle raw_image_handle, MaaControllerCallback callback,
                                    MaaCallbackTransparentArg callback_arg)
-    : ControllerMgr(callback, callback_arg), handle_(handle)
+    : ControllerMgr(callback, callback_arg), handle_(handle), raw_image_handle_(raw_image_handle)
 {}
 
 std::string CustomController::get_uuid() const
@@ -109,10 +110,76 @@ void CustomController::_press_key(PressKeyParam param)
 
 cv::Mat CustomController::_screencap()
 {
-    LogFunc << VAR_VOIDP(handle_) << VAR_VOIDP(handle_->get_image);
+    LogFunc << VAR_VOIDP(handle_) << VAR_VOIDP(raw_image_handle_) << VAR_VOIDP(handle_->get_image);
 
-    if (!handle_ || !handle_->get_image) {
-        LogError << "handle_ or handle_->get_image is nullptr";
+    if (!handle_) {
+        LogError << "handle_ is nullptr";
+        return {};
+    }
+
+    if (raw_image_handle_ && raw_image_handle_->get_raw_image) {
+        cv::Mat res = screencap_raw();
+        if (!res.empty() || !handle_->get_image) {
+            return res;
+        }
+        LogWarn << "get_raw_image failed, fallback to get_image";
+    }
+
+    return screencap_encoded();
+}
+
+void CustomController::_set_target_image_size(int width, int height)
+{
+    target_width_ = width;
+    target_height_ = height;
+}
+
+cv::Mat CustomController::screencap_raw()
+{
+    // 目标尺寸还没算出来时（第一次截图）按原始分辨率要图
+    int width = target_width_;
+    int height = target_height_;
+    if (width <= 0 || height <= 0) {
+        std::tie(width, height) = _get_resolution();
+    }
+    if (width <= 0 || height <= 0) {
+        LogError << "invalid size" << VAR(width) << VAR(height);
+        return {};
+    }
+
+    // 按 BGR 分配，每行多留一些，保证放得下 4 字节的像素；BGR 时直接截取左边一块，不用拷贝
+    int padded_cols = (width * 4 + 2) / 3;
+    cv::Mat buffer = acquire_frame_buffer(height, padded_cols, CV_8UC3);
+    MaaSize stride = buffer.step;
+
+    MaaImageFormat format = MaaImageFormat_Invalid;
+    if (!raw_image_handle_->get_raw_image(width, height, stride, buffer.data, &format)) {
+        LogError << "get_raw_image failed" << VAR(width) << VAR(height) << VAR(stride);
+        return {};
+    }
+
+    switch (format) {
+    case MaaImageFormat_BGR:
+        return buffer.colRange(0, width);
+
+    case MaaImageFormat_BGRA:
+    case MaaImageFormat_RGBA: {
+        cv::Mat four_channels(height, width, CV_8UC4, buffer.data, stride);
+        cv::Mat res = acquire_frame_buffer(height, width, CV_8UC3);
+        cv::cvtColor(four_channels, res, format == MaaImageFormat_BGRA ? cv::COLOR_BGRA2BGR : cv::COLOR_RGBA2BGR);
+        return res;
+    }
+
+    default:
+        LogError << "unknown format" << VAR(format);
+        return {};
+    }
+}
+
+cv::Mat CustomController::screencap_encoded()
+{
+    if (!handle_->get_image) {
+        LogError << "handle_->get_image is nullptr";
         return {};
     }
 
@@ -7,8 +7,8 @@ MAA_CTRL_NS_BEGIN
 class CustomController : public ControllerMgr
 {
 public:
-    CustomController(MaaCustomControllerHandle handle, MaaControllerCallback callback,
-                     MaaCallbackTransparentArg callback_arg);
+    CustomController(MaaCustomControllerHandle handle, MaaCustomControllerRawImageHandle raw_image_handle,
+                     MaaControllerCallback callback, MaaCallbackTransparentArg callback_arg);
     virtual ~CustomController() override = default;
 
     virtual std::string get_uuid() const override;
@@ -20,11 +20,18 @@ protected:
     virtual void _swipe(SwipeParam param) override;
     virtual void _press_key(PressKeyParam param) override;
     virtual cv::Mat _screencap() override;
+    virtual void _set_target_image_size(int width, int height) override;
     virtual bool _start_app(AppParam param) override;
     virtual bool _stop_app(AppParam param) override;
 
 private:
+    cv::Mat screencap_raw();
+    cv::Mat screencap_encoded();
+
     MaaCustomControllerHandle handle_ = nullptr;
+    MaaCustomControllerRawImageHandle raw_image_handle_ = nullptr;
+    int target_width_ = 0;
+    int target_height_ = 0;
 };
 
 MAA_CTRL_NS_END
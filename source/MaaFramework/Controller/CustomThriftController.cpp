@@ -2,11 +2,14 @@
 
 #include "CustomThriftController.h"
 
+#include <atomic>
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 4245 4706)
 #endif
 #include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/protocol/TCompactProtocol.h>
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/TSocket.h>
 #ifdef _MSC_VER
@@ -15,6 +18,7 @@
 
 #include "Utils/Logger.h"
 #include "Utils/NoWarningCV.hpp"
+#include "Utils/Platform.h"
 
 MAA_CTRL_NS_BEGIN
 
@@ -68,8 +72,36 @@ CustomThriftController::CustomThriftController(const std::string& param_str, Maa
         throw std::runtime_error("MaaThriftController: Unknown type");
     }
 
-    transport_ = std::make_shared<transport::TBufferedTransport>(socket);
-    auto protocol = std::make_shared<protocol::TBinaryProtocol>(transport_);
+    // 需要和服务端一致，默认保持 buffered + binary
+    auto transport_type = param_json->get("transport", std::string("buffered"));
+    auto protocol_type = param_json->get("protocol", std::string("binary"));
+    pipeline_ = param_json->get("pipeline", false);
+    // 只有同机才能共享内存，UnixDomainSocket 默认尝试协商
+    shm_enabled_ = param_json->get("shared_memory", type == "UnixDomainSocket");
+    LogInfo << VAR(transport_type) << VAR(protocol_type) << VAR(pipeline_) << VAR(shm_enabled_);
+
+    if (transport_type == "buffered") {
+        transport_ = std::make_shared<transport::TBufferedTransport>(socket);
+    }
+    else if (transport_type == "framed") {
+        transport_ = std::make_shared<transport::TFramedTransport>(socket);
+    }
+    else {
+        LogError << "Unknown transport: " << transport_type;
+        throw std::runtime_error("MaaThriftController: Unknown transport");
+    }
+
+    std::shared_ptr<protocol::TProtocol> protocol;
+    if (protocol_type == "binary") {
+        protocol = std::make_shared<protocol::TBinaryProtocol>(transport_);
+    }
+    else if (protocol_type == "compact") {
+        protocol = std::make_shared<protocol::TCompactProtocol>(transport_);
+    }
+    else {
+        LogError << "Unknown protocol: " << protocol_type;
+        throw std::runtime_error("MaaThriftController: Unknown protocol");
+    }
 
     client_ = std::make_shared<ThriftController::ThriftControllerClient>(protocol);
 }
@@ -85,18 +117,33 @@ std::string CustomThriftController::get_uuid() const
 {
     LogFunc;
 
-    if (!client_ || !transport_->isOpen()) {
-        LogError << "client_ is nullptr or transport_ is not open";
+    std::unique_lock lock { client_mutex_ };
+
+    if (uuid_cache_) {
+        return *uuid_cache_;
+    }
+    if (!ready()) {
         return {};
     }
 
+    drain_replies();
+
     std::string uuid;
     client_->get_uuid(uuid);
+    uuid_cache_ = uuid;
     return uuid;
 }
 
 bool CustomThriftController::_connect()
 {
+    std::unique_lock lock { client_mutex_ };
+
+    clear_cache();
+    // 服务端重连后不认识之前的共享内存了，等第一帧再重新协商
+    shm_ = nullptr;
+    // 旧连接上还没收的回复不会再来了
+    pending_replies_.clear();
+
     try {
         transport_->open();
     }
@@ -110,24 +157,33 @@ bool CustomThriftController::_connect()
 
 std::pair<int, int> CustomThriftController::_get_resolution() const
 {
-    LogFunc;
+    std::unique_lock lock { client_mutex_ };
 
-    if (!client_ || !transport_->isOpen()) {
-        LogError << "client_ is nullptr or transport_ is not open";
+    // 每次点击、滑动都要用来换算坐标，不能每次都走一趟 RPC
+    if (resolution_cache_) {
+        return *resolution_cache_;
+    }
+    if (!ready()) {
         return {};
     }
 
+    LogFunc;
+
+    drain_replies();
+
     ThriftController::Size resolution;
     client_->get_resolution(resolution);
-    return { resolution.width, resolution.height };
+    resolution_cache_ = std::make_pair(resolution.width, resolution.height);
+    return *resolution_cache_;
 }
 
 void CustomThriftController::_click(ClickParam param)
 {
     LogFunc << VAR(param.x) << VAR(param.y);
 
-    if (!client_ || !transport_->isOpen()) {
-        LogError << "client_ is nullptr or transport_ is not open";
+    std::unique_lock lock { client_mutex_ };
+
+    if (!ready()) {
         return;
     }
 
@@ -135,6 +191,11 @@ void CustomThriftController::_click(ClickParam param)
     click_param.point.x = param.x;
     click_param.point.y = param.y;
 
+    if (pipeline_) {
+        client_->send_click(click_param);
+        queue_reply("click", [this]() { return client_->recv_click(); });
+        return;
+    }
     client_->click(click_param);
 }
 
@@ -142,8 +203,9 @@ void CustomThriftController::_swipe(SwipeParam param)
 {
     LogFunc << VAR(param.steps.size()) << VAR(param.steps.front()) << VAR(param.steps.back());
 
-    if (!client_ || !transport_->isOpen()) {
-        LogError << "client_ is nullptr or transport_ is not open";
+    std::unique_lock lock { client_mutex_ };
+
+    if (!ready()) {
         return;
     }
 
@@ -156,6 +218,11 @@ void CustomThriftController::_swipe(SwipeParam param)
         swipe_param.steps.push_back(thrift_step);
     }
 
+    if (pipeline_) {
+        client_->send_swipe(swipe_param);
+        queue_reply("swipe", [this]() { return client_->recv_swipe(); });
+        return;
+    }
     client_->swipe(swipe_param);
 }
 
@@ -163,14 +230,20 @@ void CustomThriftController::_press_key(PressKeyParam param)
 {
     LogFunc;
 
-    if (!client_ || !transport_->isOpen()) {
-        LogError << "client_ is nullptr or transport_ is not open";
+    std::unique_lock lock { client_mutex_ };
+
+    if (!ready()) {
         return;
     }
 
     ThriftController::PressKeyParam thrift_param;
     thrift_param.keycode = param.keycode;
 
+    if (pipeline_) {
+        client_->send_press_key(thrift_param);
+        queue_reply("press_key", [this]() { return client_->recv_press_key(); });
+        return;
+    }
     client_->press_key(thrift_param);
 }
 
@@ -178,22 +251,34 @@ cv::Mat CustomThriftController::_screencap()
 {
     LogFunc;
 
-    if (!client_ || !transport_->isOpen()) {
-        LogError << "client_ is nullptr or transport_ is not open";
+    std::unique_lock lock { client_mutex_ };
+
+    if (!ready()) {
         return {};
     }
 
+    drain_replies();
+
     ThriftController::CustomImage img;
     client_->screencap(img);
+
+    if (img.__isset.shm_slot) {
+        return read_shared_frame(img);
+    }
     if (img.data.empty()) {
         LogError << "client_->screencap() return empty buffer";
         return {};
     }
 
-    cv::Mat orig_mat(img.size.width, img.size.height, img.type, img.data.data());
+    cv::Mat orig_mat(img.size.height, img.size.width, img.type, img.data.data());
     cv::Mat out_mat;
     orig_mat.copyTo(out_mat);
 
+    // 按走 socket 的这一帧的大小协商共享内存，帧变大了放不下时重新协商
+    if (shm_enabled_ && (!shm_ || img.data.size() > shm_slot_size_ - kShmHeaderSize)) {
+        negotiate_shared_memory(img.data.size());
+    }
+
     return out_mat;
 }
 
@@ -201,11 +286,15 @@ bool CustomThriftController::_start_app(AppParam param)
 {
     LogFunc << VAR(param.package);
 
-    if (!client_ || !transport_->isOpen()) {
-        LogError << "client_ is nullptr or transport_ is not open";
+    std::unique_lock lock { client_mutex_ };
+
+    if (!ready()) {
         return false;
     }
 
+    drain_replies();
+    clear_cache();
+
     return client_->start_game(param.package);
 }
 
@@ -213,12 +302,143 @@ bool CustomThriftController::_stop_app(AppParam param)
 {
     LogFunc << VAR(param.package);
 
+    std::unique_lock lock { client_mutex_ };
+
+    if (!ready()) {
+        return false;
+    }
+
+    drain_replies();
+    clear_cache();
+
+    return client_->stop_game(param.package);
+}
+
+void CustomThriftController::_wait_inputs()
+{
+    std::unique_lock lock { client_mutex_ };
+
+    if (!ready()) {
+        return;
+    }
+    drain_replies();
+}
+
+bool CustomThriftController::ready() const
+{
     if (!client_ || !transport_->isOpen()) {
         LogError << "client_ is nullptr or transport_ is not open";
         return false;
     }
+    return true;
+}
 
-    return client_->stop_game(param.package);
+void CustomThriftController::drain_replies() const
+{
+    while (!pending_replies_.empty()) {
+        auto [name, recv] = std::move(pending_replies_.front());
+        pending_replies_.pop_front();
+
+        try {
+            if (!recv()) {
+                LogError << "pipelined call failed" << VAR(name);
+            }
+        }
+        catch (const std::exception& e) {
+            // 连接出错后剩下的回复都收不到了，留着会让后面的调用读错位
+            LogError << "pipelined call threw" << VAR(name) << VAR(e.what());
+            pending_replies_.clear();
+            throw;
+        }
+    }
+}
+
+void CustomThriftController::queue_reply(std::string name, std::function<bool()> recv)
+{
+    pending_replies_.emplace_back(std::move(name), std::move(recv));
+
+    // 服务端的发送缓冲有限，回复攒太多会把两边都堵住
+    constexpr size_t kMaxPendingReplies = 16;
+    if (pending_replies_.size() >= kMaxPendingReplies) {
+        drain_replies();
+    }
+}
+
+bool CustomThriftController::negotiate_shared_memory(size_t frame_size)
+{
+    LogFunc << VAR(frame_size);
+
+    const size_t page_size = get_page_size();
+    const size_t slot_size = (kShmHeaderSize + frame_size + page_size - 1) / page_size * page_size;
+
+    auto shm = shared_memory::create(slot_size * kShmSlotCount);
+    if (!shm) {
+        LogWarn << "failed to create shared memory, fallback to socket";
+        shm_enabled_ = false;
+        shm_ = nullptr;
+        return false;
+    }
+
+    const json::value option = {
+        { "name", shm->name() },
+        { "slot_count", kShmSlotCount },
+        { "slot_size", slot_size },
+        { "header_size", kShmHeaderSize },
+    };
+    if (!client_->set_option("shared_memory", option.to_string())) {
+        LogWarn << "server refused shared memory, fallback to socket" << VAR(option);
+        shm_enabled_ = false;
+        shm_ = nullptr;
+        return false;
+    }
+
+    LogInfo << "shared memory accepted" << VAR(option);
+    shm_ = std::move(shm);
+    shm_slot_size_ = slot_size;
+    return true;
+}
+
+cv::Mat CustomThriftController::read_shared_frame(const ThriftController::CustomImage& img) const
+{
+    if (!shm_ || img.shm_slot < 0 || static_cast<size_t>(img.shm_slot) >= kShmSlotCount || !img.__isset.frame_id ||
+        img.frame_id <= 0) {
+        LogError << "invalid shared frame" << VAR(shm_ != nullptr) << VAR(img.shm_slot) << VAR(img.frame_id);
+        return {};
+    }
+
+    const size_t frame_size = static_cast<size_t>(img.size.width) * img.size.height * CV_ELEM_SIZE(img.type);
+    if (img.size.width <= 0 || img.size.height <= 0 || frame_size > shm_slot_size_ - kShmHeaderSize) {
+        LogError << "shared frame out of slot" << VAR(frame_size) << VAR(shm_slot_size_);
+        return {};
+    }
+
+    auto* slot = static_cast<uint8_t*>(shm_->data()) + static_cast<size_t>(img.shm_slot) * shm_slot_size_;
+    std::atomic_ref<uint64_t> slot_frame_id(*reinterpret_cast<uint64_t*>(slot));
+    const auto frame_id = static_cast<uint64_t>(img.frame_id);
+
+    if (slot_frame_id.load(std::memory_order_acquire) != frame_id) {
+        LogError << "shared frame not ready" << VAR(img.shm_slot) << VAR(frame_id);
+        return {};
+    }
+
+    cv::Mat orig_mat(img.size.height, img.size.width, img.type, slot + kShmHeaderSize);
+    cv::Mat out_mat;
+    orig_mat.copyTo(out_mat);
+
+    // 拷贝期间服务端可能已经开始往这个槽写下一帧
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot_frame_id.load(std::memory_order_relaxed) != frame_id) {
+        LogError << "shared frame overwritten while reading" << VAR(img.shm_slot) << VAR(frame_id);
+        return {};
+    }
+
+    return out_mat;
+}
+
+void CustomThriftController::clear_cache()
+{
+    resolution_cache_.reset();
+    uuid_cache_.reset();
 }
 
 MAA_CTRL_NS_END
@@ -2,7 +2,13 @@
 
 #ifdef WITH_THRIFT
 
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+
 #include "ControllerMgr.h"
+#include "Utils/Platform.h"
 
 #include "ThriftController.h"
 
@@ -25,11 +31,40 @@ protected:
     virtual cv::Mat _screencap() override;
     virtual bool _start_app(AppParam param) override;
     virtual bool _stop_app(AppParam param) override;
+    virtual void _wait_inputs() override;
 
 private:
+    bool ready() const;
+    // 读回之前流水线发出的输入调用的回复，之后才能做需要回复的调用
+    void drain_replies() const;
+    void queue_reply(std::string name, std::function<bool()> recv);
+    void clear_cache();
+
+    // 用第一帧的大小建共享内存并通过 set_option 交给服务端，服务端之后只回槽号和帧号
+    bool negotiate_shared_memory(size_t frame_size);
+    cv::Mat read_shared_frame(const ThriftController::CustomImage& img) const;
+
     std::shared_ptr<ThriftController::ThriftControllerClient> client_ = nullptr;
     std::shared_ptr<apache::thrift::transport::TTransport> transport_ = nullptr;
 
+    // get_uuid 可能在其他线程被调用，client 不能并发使用
+    mutable std::mutex client_mutex_;
+
+    // 输入调用只发不等，回复攒着按顺序读
+    bool pipeline_ = false;
+    mutable std::deque<std::pair<std::string, std::function<bool()>>> pending_replies_;
+
+    // connect / start_app / stop_app 之后失效
+    mutable std::optional<std::pair<int, int>> resolution_cache_;
+    mutable std::optional<std::string> uuid_cache_;
+
+    static constexpr size_t kShmSlotCount = 3;
+    // 槽头里放 frame_id，像素从这里开始，对齐到 cache line
+    static constexpr size_t kShmHeaderSize = 64;
+    bool shm_enabled_ = false;
+    std::unique_ptr<shared_memory> shm_ = nullptr;
+    size_t shm_slot_size_ = 0;
+
     enum ThriftControllerTypeEnum
     {
         // param format should be "host:port"
@@ -134,15 +134,16 @@ bool InstanceMgr::set_task_param(MaaTaskId task_id, std::string_view param)
     return ret;
 }
 
-bool InstanceMgr::register_custom_recognizer(std::string name, MaaCustomRecognizerHandle handle)
+bool InstanceMgr::register_custom_recognizer(std::string name, MaaCustomRecognizerHandle handle,
+                                             MaaSize detail_buff_size)
 {
-    LogInfo << VAR(name) << VAR_VOIDP(handle);
+    LogInfo << VAR(name) << VAR_VOIDP(handle) << VAR(detail_buff_size);
     if (!handle) {
         LogError << "Invalid handle";
         return false;
     }
 
-    auto recognizer_ptr = std::make_shared<MAA_VISION_NS::CustomRecognizer>(handle, this);
+    auto recognizer_ptr = std::make_shared<MAA_VISION_NS::CustomRecognizer>(handle, detail_buff_size, this);
     return custom_recognizers_.insert_or_assign(std::move(name), std::move(recognizer_ptr)).second;
 }
 
@@ -299,6 +300,7 @@ bool InstanceMgr::run_task(TaskId id, TaskPtr task_ptr)
     notifier.notify(ret ? MaaMsg_Task_Completed : MaaMsg_Task_Failed, details);
 
     status_.clear_pipeline_run_times();
+    status_.clear_ocr_track_cache();
 
     Logger::get_instance().flush();
 
@@ -26,6 +26,27 @@ void InstanceStatus::clear_pipeline_rec_cache()
     pipeline_rec_cache_map_.clear();
 }
 
+const MAA_VISION_NS::OcrTrackCache* InstanceStatus::get_ocr_track_cache(const std::string& key) const
+{
+    auto it = ocr_track_cache_map_.find(key);
+    if (it == ocr_track_cache_map_.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void InstanceStatus::set_ocr_track_cache(std::string key, MAA_VISION_NS::OcrTrackCache cache)
+{
+    ocr_track_cache_map_.insert_or_assign(std::move(key), std::move(cache));
+}
+
+void InstanceStatus::clear_ocr_track_cache()
+{
+    LogInfo;
+
+    ocr_track_cache_map_.clear();
+}
+
 uint64_t InstanceStatus::get_pipeline_run_times(const std::string& task) const
 {
     auto it = pipeline_run_times_map_.find(task);
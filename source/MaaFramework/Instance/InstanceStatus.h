@@ -7,6 +7,7 @@
 #include <string>
 
 #include "Utils/NoWarningCVMat.hpp"
+#include "Vision/VisionTypes.h"
 
 MAA_NS_BEGIN
 
@@ -17,12 +18,17 @@ public:
     void set_pipeline_rec_cache(std::string task, cv::Rect rec);
     void clear_pipeline_rec_cache();
 
+    const MAA_VISION_NS::OcrTrackCache* get_ocr_track_cache(const std::string& key) const;
+    void set_ocr_track_cache(std::string key, MAA_VISION_NS::OcrTrackCache cache);
+    void clear_ocr_track_cache();
+
     uint64_t get_pipeline_run_times(const std::string& task) const;
     void increase_pipeline_run_times(const std::string& task, int times = 1);
     void clear_pipeline_run_times();
 
 private:
     std::map<std::string, cv::Rect> pipeline_rec_cache_map_;
+    std::map<std::string, MAA_VISION_NS::OcrTrackCache> ocr_track_cache_map_;
     std::map<std::string, uint64_t> pipeline_run_times_map_;
 };
 
@@ -0,0 +1,105 @@
+#include "ONNXConfig.h"
+
+#include "Utils/File.hpp"
+#include "Utils/Logger.h"
+#include "Utils/Platform.h"
+#include "Utils/Ranges.hpp"
+
+MAA_RES_NS_BEGIN
+
+ONNXConfig::ONNXConfig() : env_(ORT_LOGGING_LEVEL_WARNING, "MaaFramework")
+{
+    options_.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+}
+
+bool ONNXConfig::lazy_load(const std::filesystem::path& path, bool is_base)
+{
+    LogFunc << VAR(path) << VAR(is_base);
+
+    if (is_base) {
+        clear();
+    }
+
+    using namespace path_literals;
+    const auto classifier_dir = path / "classify"_p;
+    if (std::filesystem::exists(classifier_dir)) {
+        classifier_roots_.emplace_back(classifier_dir);
+        // 新的资源可能覆盖同名模型
+        classifiers_.clear();
+    }
+
+    const auto detector_dir = path / "detect"_p;
+    if (std::filesystem::exists(detector_dir)) {
+        detector_roots_.emplace_back(detector_dir);
+        detectors_.clear();
+    }
+
+    LogInfo << VAR(classifier_roots_) << VAR(detector_roots_);
+
+    // 模型是可选的，没有也不算加载失败
+    return true;
+}
+
+void ONNXConfig::clear()
+{
+    LogFunc;
+
+    classifiers_.clear();
+    classifier_roots_.clear();
+    detectors_.clear();
+    detector_roots_.clear();
+}
+
+std::shared_ptr<Ort::Session> ONNXConfig::classifier(const std::string& name) const
+{
+    return load_session(name, classifier_roots_, classifiers_);
+}
+
+std::shared_ptr<Ort::Session> ONNXConfig::detector(const std::string& name) const
+{
+    return load_session(name, detector_roots_, detectors_);
+}
+
+std::shared_ptr<Ort::Session> ONNXConfig::load_session(const std::string& name,
+                                                       const std::vector<std::filesystem::path>& roots,
+                                                       SessionMap& sessions) const
+{
+    if (auto iter = sessions.find(name); iter != sessions.end()) {
+        return iter->second;
+    }
+
+    LogFunc << VAR(name) << VAR(roots);
+
+    std::filesystem::path model_path;
+    for (const auto& root : roots | MAA_RNS::views::reverse) {
+        auto path = root / MAA_NS::path(name);
+        if (std::filesystem::exists(path)) {
+            model_path = std::move(path);
+            break;
+        }
+    }
+    if (model_path.empty()) {
+        LogError << "model not found" << VAR(name) << VAR(roots);
+        return nullptr;
+    }
+
+    auto model = read_file<std::string>(model_path);
+    if (model.empty()) {
+        LogError << "failed to read model" << VAR(model_path);
+        return nullptr;
+    }
+
+    std::shared_ptr<Ort::Session> session;
+    try {
+        session = std::make_shared<Ort::Session>(env_, model.data(), model.size(), options_);
+    }
+    catch (const Ort::Exception& e) {
+        LogError << "failed to create session" << VAR(model_path) << VAR(e.what());
+        return nullptr;
+    }
+
+    sessions.emplace(name, session);
+    return session;
+}
+
+MAA_RES_NS_END
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Utils/NonCopyable.hpp"
+#include "Conf/Conf.h"
+
+#include <filesystem>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <onnxruntime/core/session/onnxruntime_cxx_api.h>
+
+MAA_RES_NS_BEGIN
+
+class ONNXConfig : public NonCopyable
+{
+public:
+    ONNXConfig();
+    bool lazy_load(const std::filesystem::path& path, bool is_base);
+    void clear();
+
+public:
+    std::shared_ptr<Ort::Session> classifier(const std::string& name) const;
+    std::shared_ptr<Ort::Session> detector(const std::string& name) const;
+
+private:
+    using SessionMap = std::unordered_map<std::string, std::shared_ptr<Ort::Session>>;
+
+    std::shared_ptr<Ort::Session> load_session(const std::string& name,
+                                               const std::vector<std::filesystem::path>& roots,
+                                               SessionMap& sessions) const;
+
+private:
+    // 后加载的资源优先
+    std::vector<std::filesystem::path> classifier_roots_;
+    std::vector<std::filesystem::path> detector_roots_;
+
+    mutable SessionMap classifiers_;
+    mutable SessionMap detectors_;
+
+    Ort::Env env_;
+    Ort::SessionOptions options_;
+};
+
+MAA_RES_NS_END
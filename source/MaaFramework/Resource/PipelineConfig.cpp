@@ -1,6 +1,7 @@
 #include "PipelineConfig.h"
 
 #include "Utils/Logger.h"
+#include "Utils/Ranges.hpp"
 #include "Vision/VisionTypes.h"
 
 #include <tuple>
@@ -348,6 +349,8 @@ bool PipelineConfig::parse_recognition(const json::value& input, MAA_PIPELINE_RE
         { "DirectHit", Type::DirectHit },
         { "TemplateMatch", Type::TemplateMatch },
         { "OCR", Type::OCR },
+        { "Classify", Type::Classify },
+        { "Detect", Type::Detect },
         { "Custom", Type::Custom },
     };
     auto rec_type_iter = kRecTypeMap.find(rec_type_name);
@@ -375,6 +378,16 @@ bool PipelineConfig::parse_recognition(const json::value& input, MAA_PIPELINE_RE
         return parse_ocr_param(input, std::get<OcrParam>(out_param),
                                same_type ? std::get<OcrParam>(default_param) : OcrParam {});
 
+    case Type::Classify:
+        out_param = ClassifierParam {};
+        return parse_classifier_param(input, std::get<ClassifierParam>(out_param),
+                                      same_type ? std::get<ClassifierParam>(default_param) : ClassifierParam {});
+
+    case Type::Detect:
+        out_param = DetectorParam {};
+        return parse_detector_param(input, std::get<DetectorParam>(out_param),
+                                    same_type ? std::get<DetectorParam>(default_param) : DetectorParam {});
+
     case Type::Custom:
         out_param = CustomParam {};
         return parse_custom_recognizer_param(input, std::get<CustomParam>(out_param),
@@ -463,6 +476,24 @@ bool PipelineConfig::parse_ocr_param(const json::value& input, MAA_VISION_NS::Oc
         return false;
     }
 
+    if (!get_and_check_value(input, "det_max_side", output.det_max_side, default_value.det_max_side)) {
+        LogError << "failed to get_and_check_value det_max_side" << VAR(input);
+        return false;
+    }
+    if (output.det_max_side < 0) {
+        LogError << "det_max_side is negative" << VAR(output.det_max_side);
+        return false;
+    }
+
+    if (!get_and_check_value(input, "det_scale", output.det_scale, default_value.det_scale)) {
+        LogError << "failed to get_and_check_value det_scale" << VAR(input);
+        return false;
+    }
+    if (output.det_scale <= 0 || output.det_scale > 1) {
+        LogError << "det_scale is out of range (0, 1]" << VAR(output.det_scale);
+        return false;
+    }
+
     if (auto replace_opt = input.find("replace")) {
         if (!replace_opt->is_array()) {
             LogError << "replace is not array" << VAR(input);
@@ -495,9 +526,103 @@ bool PipelineConfig::parse_ocr_param(const json::value& input, MAA_VISION_NS::Oc
     return true;
 }
 
+bool PipelineConfig::parse_classifier_param(const json::value& input, MAA_VISION_NS::ClassifierParam& output,
+                                            const MAA_VISION_NS::ClassifierParam& default_value)
+{
+    if (!parse_roi(input, output.roi, default_value.roi)) {
+        LogError << "failed to parse_roi" << VAR(input);
+        return false;
+    }
+
+    if (!get_and_check_value(input, "model", output.model, default_value.model)) {
+        LogError << "failed to get_and_check_value model" << VAR(input);
+        return false;
+    }
+    if (output.model.empty()) {
+        LogError << "model is empty" << VAR(input);
+        return false;
+    }
+
+    if (!get_and_check_value_or_array(input, "labels", output.labels, default_value.labels)) {
+        LogError << "failed to get_and_check_value_or_array labels" << VAR(input);
+        return false;
+    }
+
+    std::vector<int> expected;
+    std::vector<int> default_expected(default_value.expected.begin(), default_value.expected.end());
+    if (!get_and_check_value_or_array(input, "expected", expected, default_expected)) {
+        LogError << "failed to get_and_check_value_or_array expected" << VAR(input);
+        return false;
+    }
+    if (expected.empty()) {
+        LogError << "expected is empty" << VAR(input);
+        return false;
+    }
+    output.expected.clear();
+    for (int cls_index : expected) {
+        if (cls_index < 0 || (!output.labels.empty() && static_cast<size_t>(cls_index) >= output.labels.size())) {
+            LogError << "expected is out of range" << VAR(cls_index) << VAR(output.labels.size());
+            return false;
+        }
+        output.expected.emplace_back(static_cast<size_t>(cls_index));
+    }
+
+    return true;
+}
+
+bool PipelineConfig::parse_detector_param(const json::value& input, MAA_VISION_NS::DetectorParam& output,
+                                          const MAA_VISION_NS::DetectorParam& default_value)
+{
+    if (!parse_roi(input, output.roi, default_value.roi)) {
+        LogError << "failed to parse_roi" << VAR(input);
+        return false;
+    }
+
+    if (!get_and_check_value(input, "model", output.model, default_value.model)) {
+        LogError << "failed to get_and_check_value model" << VAR(input);
+        return false;
+    }
+    if (output.model.empty()) {
+        LogError << "model is empty" << VAR(input);
+        return false;
+    }
+
+    if (!get_and_check_value_or_array(input, "labels", output.labels, default_value.labels)) {
+        LogError << "failed to get_and_check_value_or_array labels" << VAR(input);
+        return false;
+    }
+
+    if (!get_and_check_value_or_array(input, "expected", output.expected, default_value.expected)) {
+        LogError << "failed to get_and_check_value_or_array expected" << VAR(input);
+        return false;
+    }
+
+    output.expected_indices.clear();
+    for (const auto& name : output.expected) {
+        auto iter = MAA_RNS::ranges::find(output.labels, name);
+        if (iter == output.labels.end()) {
+            LogError << "expected is not in labels" << VAR(name) << VAR(output.labels);
+            return false;
+        }
+        output.expected_indices.emplace_back(static_cast<size_t>(std::distance(output.labels.begin(), iter)));
+    }
+
+    if (!get_and_check_value(input, "threshold", output.threshold, default_value.threshold)) {
+        LogError << "failed to get_and_check_value threshold" << VAR(input);
+        return false;
+    }
+
+    return true;
+}
+
 bool PipelineConfig::parse_custom_recognizer_param(const json::value& input, MAA_VISION_NS::CustomParam& output,
                                                    const MAA_VISION_NS::CustomParam& default_value)
 {
+    if (!parse_roi(input, output.roi, default_value.roi)) {
+        LogError << "failed to parse_roi" << VAR(input);
+        return false;
+    }
+
     if (!get_and_check_value(input, "custom_recognizer", output.name, default_value.name)) {
         LogError << "failed to get_and_check_value custom_recognizer" << VAR(input);
         return false;
@@ -106,6 +106,7 @@ bool ResourceMgr::load(const std::filesystem::path& path)
 
     bool ret = pipeline_cfg_.load(path / "pipeline", is_base);
     ret &= ocr_cfg_.lazy_load(path / "model" / "ocr", is_base);
+    ret &= onnx_cfg_.lazy_load(path / "model", is_base);
 
     LogInfo << VAR(path) << VAR(ret);
 
@@ -4,6 +4,7 @@
 #include "Base/AsyncRunner.hpp"
 #include "Base/MessageNotifier.hpp"
 #include "OCRConfig.h"
+#include "ONNXConfig.h"
 #include "PipelineConfig.h"
 #include "TemplateConfig.h"
 
@@ -32,6 +33,8 @@ public:
     auto& pipeline_cfg() { return pipeline_cfg_; }
     const auto& ocr_cfg() const { return ocr_cfg_; }
     auto& ocr_cfg() { return ocr_cfg_; }
+    const auto& onnx_cfg() const { return onnx_cfg_; }
+    auto& onnx_cfg() { return onnx_cfg_; }
 
 private:
     bool run_load(typename AsyncRunner<std::filesystem::path>::Id id, std::filesystem::path path);
@@ -41,6 +44,7 @@ private:
     PipelineConfig pipeline_cfg_;
     // TemplateConfig template_cfg_;
     OCRConfig ocr_cfg_;
+    ONNXConfig onnx_cfg_;
 
 private:
     std::vector<std::filesystem::path> paths_;
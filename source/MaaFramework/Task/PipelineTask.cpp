@@ -6,8 +6,10 @@
 #include "Task/CustomAction.h"
 #include "Utils/ImageIo.h"
 #include "Utils/Logger.h"
+#include "Vision/Classifier.h"
 #include "Vision/Comparator.h"
 #include "Vision/CustomRecognizer.h"
+#include "Vision/Detector.h"
 #include "Vision/Matcher.h"
 #include "Vision/OCRer.h"
 #include "Vision/VisionUtils.hpp"
@@ -267,6 +269,14 @@ std::optional<PipelineTask::RecResult> PipelineTask::recognize(const cv::Mat& im
         result = ocr(image, std::get<OcrParam>(task_data.rec_param), cache, task_data.name);
         break;
 
+    case Type::Classify:
+        result = classify(image, std::get<ClassifierParam>(task_data.rec_param), cache, task_data.name);
+        break;
+
+    case Type::Detect:
+        result = detect(image, std::get<DetectorParam>(task_data.rec_param), cache, task_data.name);
+        break;
+
     case Type::Custom:
         result = custom_recognize(image, std::get<CustomParam>(task_data.rec_param), cache, task_data.name);
         break;
@@ -339,6 +349,44 @@ std::optional<PipelineTask::RecResult> PipelineTask::ocr(const cv::Mat& image, c
     return RecResult { .box = res.front().box };
 }
 
+std::optional<PipelineTask::RecResult> PipelineTask::classify(const cv::Mat& image,
+                                                              const MAA_VISION_NS::ClassifierParam& param,
+                                                              const cv::Rect& cache, const std::string& name)
+{
+    using namespace MAA_VISION_NS;
+
+    Classifier classifier(inst_, image);
+    classifier.set_param(param);
+    classifier.set_cache(cache);
+    classifier.set_name(name);
+
+    auto ret = classifier.analyze();
+    if (!ret) {
+        return std::nullopt;
+    }
+
+    return RecResult { .box = ret->front().box };
+}
+
+std::optional<PipelineTask::RecResult> PipelineTask::detect(const cv::Mat& image,
+                                                            const MAA_VISION_NS::DetectorParam& param,
+                                                            const cv::Rect& cache, const std::string& name)
+{
+    using namespace MAA_VISION_NS;
+
+    Detector detector(inst_, image);
+    detector.set_param(param);
+    detector.set_cache(cache);
+    detector.set_name(name);
+
+    auto ret = detector.analyze();
+    if (!ret) {
+        return std::nullopt;
+    }
+
+    return RecResult { .box = ret->front().box };
+}
+
 std::optional<PipelineTask::RecResult> PipelineTask::custom_recognize(const cv::Mat& image,
                                                                       const MAA_VISION_NS::CustomParam& param,
                                                                       const cv::Rect& cache, const std::string& name)
@@ -407,12 +455,56 @@ PipelineTask::RunningResult PipelineTask::start_to_act(const FoundResult& act)
         break;
     }
 
+    // 操作只是排进了控制器的队列，趁设备执行的这段时间把下一轮识别要用的东西准备好
+    prepare_recognition(act.task_data.next);
+    // post_delay 从操作真正做完开始算
+    if (controller()) {
+        controller()->wait_actions();
+    }
+
     wait_freezes(act.task_data.post_wait_freezes, act.rec.box);
     sleep(act.task_data.post_delay);
 
     return RunningResult::Success;
 }
 
+void PipelineTask::prepare_recognition(const std::vector<std::string>& list)
+{
+    using namespace MAA_PIPELINE_RES_NS::Recognition;
+    using namespace MAA_VISION_NS;
+
+    if (!resource()) {
+        return;
+    }
+
+    // 模型都是第一次用到时才加载的，提前触发一下；任务数据本身已经随资源解析好了
+    for (const std::string& name : list) {
+        const auto& task_data = get_task_data(name);
+        if (!task_data.enabled) {
+            continue;
+        }
+
+        switch (task_data.rec_type) {
+        case Type::OCR:
+            if (std::get<OcrParam>(task_data.rec_param).only_rec) {
+                resource()->ocr_cfg().recer();
+            }
+            else {
+                resource()->ocr_cfg().ocrer();
+            }
+            break;
+        case Type::Classify:
+            resource()->onnx_cfg().classifier(std::get<ClassifierParam>(task_data.rec_param).model);
+            break;
+        case Type::Detect:
+            resource()->onnx_cfg().detector(std::get<DetectorParam>(task_data.rec_param).model);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 void PipelineTask::click(const MAA_PIPELINE_RES_NS::Action::ClickParam& param, const cv::Rect& cur_box)
 {
     if (!controller()) {
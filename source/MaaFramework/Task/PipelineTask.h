@@ -69,6 +69,10 @@ private:
                                             const cv::Rect& cache, const std::string& name);
     std::optional<RecResult> ocr(const cv::Mat& image, const MAA_VISION_NS::OcrParam& param, const cv::Rect& cache,
                                  const std::string& name);
+    std::optional<RecResult> classify(const cv::Mat& image, const MAA_VISION_NS::ClassifierParam& param,
+                                      const cv::Rect& cache, const std::string& name);
+    std::optional<RecResult> detect(const cv::Mat& image, const MAA_VISION_NS::DetectorParam& param,
+                                    const cv::Rect& cache, const std::string& name);
     std::optional<RecResult> custom_recognize(const cv::Mat& image, const MAA_VISION_NS::CustomParam& param,
                                               const cv::Rect& cache, const std::string& name);
 
@@ -83,6 +87,7 @@ private:
                        const cv::Rect& cur_box);
 
     void wait_freezes(const MAA_PIPELINE_RES_NS::WaitFreezesParam& param, const cv::Rect& cur_box);
+    void prepare_recognition(const std::vector<std::string>& list);
 
     cv::Rect get_target_rect(const MAA_PIPELINE_RES_NS::Action::Target target, const cv::Rect& cur_box);
 
@@ -60,17 +60,23 @@ void SyncContext::swipe(std::vector<int> x_steps, std::vector<int> y_steps, std:
 }
 
 std::vector<uint8_t> SyncContext::screencap()
+{
+    if (!capture()) {
+        return {};
+    }
+    return controller()->get_image_cache();
+}
+
+bool SyncContext::capture()
 {
     LogFunc;
     auto* ctrl = controller();
     if (!ctrl) {
         LogError << "Controller is null";
-        return {};
+        return false;
     }
     auto id = ctrl->post_screencap();
-    ctrl->wait(id);
-
-    return ctrl->get_image_cache();
+    return ctrl->wait(id) == MaaStatus_Success;
 }
 
 std::string SyncContext::task_result(const std::string& task_name) const
@@ -25,6 +25,7 @@ public: // from MaaSyncContextAPI
     virtual void click(int x, int y) override;
     virtual void swipe(std::vector<int> x_steps, std::vector<int> y_steps, std::vector<int> step_delay) override;
     virtual std::vector<uint8_t> screencap() override;
+    virtual bool capture() override;
 
     virtual std::string task_result(const std::string& task_name) const override;
 
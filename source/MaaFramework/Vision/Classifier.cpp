@@ -0,0 +1,157 @@
+#include "Classifier.h"
+
+#include "Resource/ResourceMgr.h"
+#include "Utils/Logger.h"
+#include "Utils/Ranges.hpp"
+#include "Utils/Time.hpp"
+#include "VisionUtils.hpp"
+
+MAA_VISION_NS_BEGIN
+
+std::ostream& operator<<(std::ostream& os, const Classifier::Result& res)
+{
+    os << VAR_RAW(res.cls_index) << VAR_RAW(res.label) << VAR_RAW(res.score) << VAR_RAW(res.box);
+    return os;
+}
+
+Classifier::ResultOpt Classifier::analyze() const
+{
+    std::vector<cv::Rect> rois;
+    if (!cache_.empty()) {
+        rois = { cache_ };
+    }
+    else if (param_.roi.empty()) {
+        rois = { cv::Rect(0, 0, image_.cols, image_.rows) };
+    }
+    else {
+        rois = param_.roi;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    // 所有 roi 合成一个 batch，只跑一次推理
+    auto results = predict(rois);
+
+    auto costs = duration_since(start_time);
+    LogDebug << name_ << VAR(results) << VAR(param_.expected) << VAR(rois.size()) << VAR(costs);
+
+    if (debug_draw_) {
+        draw_result(results);
+    }
+
+    std::erase_if(results, [&](const Result& res) { return !filter_by_expected(res); });
+    if (results.empty()) {
+        return std::nullopt;
+    }
+
+    sort_by_score_(results);
+    return results;
+}
+
+Classifier::ResultsVec Classifier::predict(const std::vector<cv::Rect>& rois) const
+{
+    if (!resource()) {
+        LogError << "Resource not binded";
+        return {};
+    }
+
+    auto session = resource()->onnx_cfg().classifier(param_.model);
+    if (!session) {
+        LogError << "classifier session is null" << VAR(param_.model);
+        return {};
+    }
+
+    ResultsVec results;
+
+    try {
+        // NCHW
+        auto input_shape = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        if (input_shape.size() != 4 || input_shape[1] != 3 || input_shape[2] <= 0 || input_shape[3] <= 0) {
+            LogError << "unsupported input shape" << VAR(param_.model) << VAR(input_shape);
+            return {};
+        }
+        const cv::Size input_size(static_cast<int>(input_shape[3]), static_cast<int>(input_shape[2]));
+        const size_t image_tensor_size = 3ULL * input_size.area();
+
+        // 模型的 batch 维度是动态的则一次跑完，否则按模型的 batch 分段，不足的补零
+        const size_t batch_size = input_shape[0] > 0 ? static_cast<size_t>(input_shape[0]) : rois.size();
+        input_shape[0] = static_cast<int64_t>(batch_size);
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        auto input_name = session->GetInputNameAllocated(0, allocator);
+        auto output_name = session->GetOutputNameAllocated(0, allocator);
+        const char* input_names[] = { input_name.get() };
+        const char* output_names[] = { output_name.get() };
+
+        auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+
+        std::vector<float> tensor(batch_size * image_tensor_size);
+        cv::Mat resized;
+
+        for (size_t begin = 0; begin < rois.size(); begin += batch_size) {
+            const size_t count = std::min(batch_size, rois.size() - begin);
+
+            for (size_t i = 0; i != count; ++i) {
+                cv::resize(image_with_roi(rois.at(begin + i)), resized, input_size, 0, 0, cv::INTER_AREA);
+                if (!image_to_tensor(resized, tensor.data() + i * image_tensor_size)) {
+                    return {};
+                }
+            }
+            std::fill(tensor.begin() + count * image_tensor_size, tensor.end(), 0.0f);
+
+            auto input = Ort::Value::CreateTensor<float>(memory_info, tensor.data(), tensor.size(),
+                                                         input_shape.data(), input_shape.size());
+            auto outputs = session->Run(Ort::RunOptions { nullptr }, input_names, &input, 1, output_names, 1);
+
+            const auto output_shape = outputs.front().GetTensorTypeAndShapeInfo().GetShape();
+            if (output_shape.size() != 2 || static_cast<size_t>(output_shape[0]) != batch_size) {
+                LogError << "unsupported output shape" << VAR(param_.model) << VAR(output_shape);
+                return {};
+            }
+            const size_t cls_count = static_cast<size_t>(output_shape[1]);
+            const float* output_data = outputs.front().GetTensorData<float>();
+
+            for (size_t i = 0; i != count; ++i) {
+                Result res;
+                res.raw.assign(output_data + i * cls_count, output_data + (i + 1) * cls_count);
+                res.probs = softmax(res.raw);
+                res.cls_index =
+                    static_cast<size_t>(std::distance(res.probs.begin(), MAA_RNS::ranges::max_element(res.probs)));
+                res.score = res.probs.at(res.cls_index);
+                res.label = res.cls_index < param_.labels.size() ? param_.labels.at(res.cls_index) : std::string();
+                res.box = rois.at(begin + i);
+                results.emplace_back(std::move(res));
+            }
+        }
+    }
+    catch (const Ort::Exception& e) {
+        LogError << "onnxruntime error" << VAR(param_.model) << VAR(e.what());
+        return {};
+    }
+
+    return results;
+}
+
+void Classifier::draw_result(const ResultsVec& results) const
+{
+    cv::Mat image_draw = image_.clone();
+    const auto color = cv::Scalar(0, 0, 255);
+    cv::putText(image_draw, name_, cv::Point(5, image_.rows - 5), cv::FONT_HERSHEY_SIMPLEX, 1, color, 2);
+
+    for (const Result& res : results) {
+        cv::rectangle(image_draw, res.box, color, 1);
+        std::string flag = MAA_FMT::format("{} {}: {:.3f}", res.cls_index, res.label, res.score);
+        cv::putText(image_draw, flag, cv::Point(res.box.x, res.box.y - 5), cv::FONT_HERSHEY_PLAIN, 1.2, color, 1);
+    }
+
+    if (save_draw_) {
+        save_image(image_draw);
+    }
+}
+
+bool Classifier::filter_by_expected(const Result& res) const
+{
+    return MAA_RNS::ranges::find(param_.expected, res.cls_index) != param_.expected.end();
+}
+
+MAA_VISION_NS_END
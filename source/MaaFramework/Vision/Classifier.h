@@ -0,0 +1,44 @@
+#pragma once
+
+#include "VisionBase.h"
+
+#include <optional>
+#include <vector>
+
+#include "VisionTypes.h"
+
+MAA_VISION_NS_BEGIN
+
+class Classifier : public VisionBase
+{
+public:
+    struct Result
+    {
+        size_t cls_index = SIZE_MAX;
+        std::string label;
+        std::vector<float> raw;
+        std::vector<float> probs;
+        double score = 0.0;
+        cv::Rect box {};
+    };
+
+    using ResultsVec = std::vector<Result>;
+    using ResultOpt = std::optional<ResultsVec>;
+
+public:
+    using VisionBase::VisionBase;
+
+    void set_param(ClassifierParam param) { param_ = std::move(param); }
+    ResultOpt analyze() const;
+
+private:
+    ResultsVec predict(const std::vector<cv::Rect>& rois) const;
+    void draw_result(const ResultsVec& results) const;
+    bool filter_by_expected(const Result& res) const;
+
+    ClassifierParam param_;
+};
+
+MAA_VISION_NS_END
+
+std::ostream& operator<<(std::ostream& os, const MAA_VISION_NS::Classifier::Result& res);
@@ -1,15 +1,29 @@
 #include "CustomRecognizer.h"
 
+#include <cstring>
+
 #include "Utils/NoWarningCV.hpp"
 
 #include "Task/SyncContext.h"
 #include "Utils/Logger.h"
+#include "VisionUtils.hpp"
 
 MAA_VISION_NS_BEGIN
 
-CustomRecognizer::CustomRecognizer(MaaCustomRecognizerHandle handle, InstanceInternalAPI* inst)
+CustomRecognizer::CustomRecognizer(MaaCustomRecognizerHandle handle, MaaSize detail_buff_size,
+                                   InstanceInternalAPI* inst)
     : VisionBase(nullptr), recognizer_(handle), inst_(inst)
-{}
+{
+    if (detail_buff_size == 0) {
+        return;
+    }
+    if (detail_buff_size > MaaRecognitionResultDetailBuffMaxSize) {
+        LogWarn << "detail_buff_size too large, clamped" << VAR(detail_buff_size)
+                << VAR(MaaRecognitionResultDetailBuffMaxSize);
+        detail_buff_size = MaaRecognitionResultDetailBuffMaxSize;
+    }
+    detail_buff_size_ = detail_buff_size;
+}
 
 CustomRecognizer::ResultOpt CustomRecognizer::analyze() const
 {
@@ -22,26 +36,46 @@ CustomRecognizer::ResultOpt CustomRecognizer::analyze() const
 
     MAA_TASK_NS::SyncContext sync_ctx(inst_);
 
-    MaaImage image {
-        .rows = image_.rows, .cols = image_.cols, .type = image_.type(), .data = static_cast<void*>(image_.data)
-    };
+    std::string detail(detail_buff_size_, '\0');
+    const std::string custom_param = param_.custom_param.to_string();
 
-    MaaRecognitionResult result;
-    std::string detail;
-    detail.resize(MaaRecognitionResultDetailBuffSize);
-    result.detail_buff = detail.data();
+    // 不设 roi 时就是全图
+    const std::vector<cv::Rect> rois = param_.roi.empty() ? std::vector<cv::Rect> { cv::Rect() } : param_.roi;
+    for (const cv::Rect& roi : rois) {
+        cv::Rect roi_corrected = correct_roi(roi, image_);
+        // 与截图共享内存，analyze 期间 image_ 持有引用，帧不会被复用
+        cv::Mat view = image_(roi_corrected);
 
-    auto success =
-        recognizer_->analyze(&sync_ctx, &image, name_.c_str(), param_.custom_param.to_string().c_str(), &result);
+        MaaImage image {
+            .rows = view.rows,
+            .cols = view.cols,
+            .type = view.type(),
+            .data = static_cast<const void*>(view.data),
+            .step = view.step,
+        };
 
-    cv::Rect box { result.box.x, result.box.y, result.box.width, result.box.height };
-    LogDebug << VAR(success) << VAR(box) << VAR(detail);
+        MaaRecognitionResult result {
+            .box = {},
+            .detail_buff = detail.data(),
+            .detail_buff_size = detail_buff_size_,
+        };
+        detail.front() = '\0';
 
-    if (!success) {
-        return std::nullopt;
+        auto success = recognizer_->analyze(&sync_ctx, &image, name_.c_str(), custom_param.c_str(), &result);
+
+        cv::Rect box { result.box.x + roi_corrected.x, result.box.y + roi_corrected.y, result.box.width,
+                       result.box.height };
+        LogDebug << VAR(success) << VAR(roi_corrected) << VAR(box);
+
+        if (success) {
+            // 识别器写的是 C 字符串，后面多出的部分不要
+            detail.resize(strnlen(detail.data(), detail.size()));
+            LogDebug << VAR(detail);
+            return Result { .box = box, .detail = std::move(detail) };
+        }
     }
 
-    return Result { .box = box, .detail = detail };
+    return std::nullopt;
 }
 
 MAA_VISION_NS_END
@@ -20,13 +20,14 @@ class CustomRecognizer : public VisionBase
     using ResultOpt = std::optional<Result>;
 
 public:
-    CustomRecognizer(MaaCustomRecognizerHandle handle, InstanceInternalAPI* inst);
+    CustomRecognizer(MaaCustomRecognizerHandle handle, MaaSize detail_buff_size, InstanceInternalAPI* inst);
 
     void set_param(CustomParam param) { param_ = std::move(param); }
     ResultOpt analyze() const;
 
 private:
     MaaCustomRecognizerHandle recognizer_ = nullptr;
+    MaaSize detail_buff_size_ = MaaRecognitionResultDetailBuffSize;
     InstanceInternalAPI* inst_ = nullptr;
 
     CustomParam param_;
@@ -0,0 +1,203 @@
+#include "Detector.h"
+
+#include "Resource/ResourceMgr.h"
+#include "Utils/Logger.h"
+#include "Utils/Ranges.hpp"
+#include "Utils/Time.hpp"
+#include "VisionUtils.hpp"
+
+MAA_VISION_NS_BEGIN
+
+std::ostream& operator<<(std::ostream& os, const Detector::Result& res)
+{
+    os << VAR_RAW(res.cls_index) << VAR_RAW(res.label) << VAR_RAW(res.box) << VAR_RAW(res.score);
+    return os;
+}
+
+Detector::ResultOpt Detector::analyze() const
+{
+    auto start_time = std::chrono::steady_clock::now();
+
+    auto results = traverse_rois();
+
+    auto costs = duration_since(start_time);
+    LogDebug << name_ << VAR(results) << VAR(param_.expected) << VAR(costs);
+
+    if (debug_draw_) {
+        draw_result(results);
+    }
+
+    std::erase_if(results, [&](const Result& res) { return !filter_by_expected(res); });
+    if (results.empty()) {
+        return std::nullopt;
+    }
+
+    sort_by_score_(results);
+    return results;
+}
+
+Detector::ResultsVec Detector::traverse_rois() const
+{
+    if (!cache_.empty()) {
+        return predict(cache_);
+    }
+
+    if (param_.roi.empty()) {
+        return predict(cv::Rect(0, 0, image_.cols, image_.rows));
+    }
+
+    ResultsVec results;
+    for (const cv::Rect& roi : param_.roi) {
+        auto cur = predict(roi);
+        results.insert(results.end(), std::make_move_iterator(cur.begin()), std::make_move_iterator(cur.end()));
+    }
+    return results;
+}
+
+Detector::ResultsVec Detector::predict(const cv::Rect& roi) const
+{
+    if (!resource()) {
+        LogError << "Resource not binded";
+        return {};
+    }
+
+    auto session = resource()->onnx_cfg().detector(param_.model);
+    if (!session) {
+        LogError << "detector session is null" << VAR(param_.model);
+        return {};
+    }
+
+    // 坐标相对 image_，用修正后的 roi 还原；image_ 本身可能就是更大的帧里的一块，不能用 locateROI
+    const cv::Rect roi_corrected = correct_roi(roi, image_);
+    cv::Mat image_roi = image_(roi_corrected);
+    if (image_roi.empty()) {
+        LogWarn << "image_roi is empty" << VAR(roi) << VAR(image_.size());
+        return {};
+    }
+    const cv::Point roi_offset = roi_corrected.tl();
+
+    ResultsVec results;
+
+    try {
+        // NCHW
+        auto input_shape = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        if (input_shape.size() != 4 || input_shape[1] != 3 || input_shape[2] <= 0 || input_shape[3] <= 0) {
+            LogError << "unsupported input shape" << VAR(param_.model) << VAR(input_shape);
+            return {};
+        }
+        input_shape[0] = 1;
+        const cv::Size input_size(static_cast<int>(input_shape[3]), static_cast<int>(input_shape[2]));
+
+        // letterbox: 等比缩放，右下补边
+        const double scale = std::min(static_cast<double>(input_size.width) / image_roi.cols,
+                                      static_cast<double>(input_size.height) / image_roi.rows);
+        const cv::Size scaled_size(std::max(1, static_cast<int>(image_roi.cols * scale)),
+                                   std::max(1, static_cast<int>(image_roi.rows * scale)));
+        cv::Mat input_image(input_size, CV_8UC3, cv::Scalar(114, 114, 114));
+        cv::resize(image_roi, input_image(cv::Rect(cv::Point(0, 0), scaled_size)), scaled_size, 0, 0,
+                   cv::INTER_LINEAR);
+
+        std::vector<float> tensor;
+        if (!image_to_tensor(input_image, tensor)) {
+            return {};
+        }
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        auto input_name = session->GetInputNameAllocated(0, allocator);
+        auto output_name = session->GetOutputNameAllocated(0, allocator);
+        const char* input_names[] = { input_name.get() };
+        const char* output_names[] = { output_name.get() };
+
+        auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        auto input = Ort::Value::CreateTensor<float>(memory_info, tensor.data(), tensor.size(), input_shape.data(),
+                                                     input_shape.size());
+        auto outputs = session->Run(Ort::RunOptions { nullptr }, input_names, &input, 1, output_names, 1);
+
+        // [1, 4 + 类别数, 候选框数] (YOLOv8) 或 [1, 候选框数, 4 + 类别数]
+        const auto output_shape = outputs.front().GetTensorTypeAndShapeInfo().GetShape();
+        if (output_shape.size() != 3 || output_shape[0] != 1) {
+            LogError << "unsupported output shape" << VAR(param_.model) << VAR(output_shape);
+            return {};
+        }
+        const size_t attr_count_hint = param_.labels.empty() ? 0 : param_.labels.size() + 4;
+        const bool attr_first = attr_count_hint ? static_cast<size_t>(output_shape[1]) == attr_count_hint
+                                                : output_shape[1] < output_shape[2];
+        const size_t attr_count = static_cast<size_t>(attr_first ? output_shape[1] : output_shape[2]);
+        const size_t box_count = static_cast<size_t>(attr_first ? output_shape[2] : output_shape[1]);
+        if (attr_count <= 4) {
+            LogError << "unsupported output shape" << VAR(param_.model) << VAR(output_shape);
+            return {};
+        }
+        const size_t cls_count = attr_count - 4;
+
+        const float* output_data = outputs.front().GetTensorData<float>();
+        auto at = [&](size_t box_index, size_t attr_index) {
+            return attr_first ? output_data[attr_index * box_count + box_index]
+                              : output_data[box_index * attr_count + attr_index];
+        };
+
+        for (size_t i = 0; i != box_count; ++i) {
+            size_t cls_index = 0;
+            float score = at(i, 4);
+            for (size_t c = 1; c < cls_count; ++c) {
+                float cur = at(i, 4 + c);
+                if (cur > score) {
+                    score = cur;
+                    cls_index = c;
+                }
+            }
+            if (score < param_.threshold) {
+                continue;
+            }
+
+            const double cx = at(i, 0);
+            const double cy = at(i, 1);
+            const double w = at(i, 2);
+            const double h = at(i, 3);
+            cv::Rect box(static_cast<int>((cx - w / 2) / scale) + roi_offset.x,
+                         static_cast<int>((cy - h / 2) / scale) + roi_offset.y, static_cast<int>(w / scale),
+                         static_cast<int>(h / scale));
+
+            results.emplace_back(Result {
+                .cls_index = cls_index,
+                .label = cls_index < param_.labels.size() ? param_.labels.at(cls_index) : std::string(),
+                .box = box,
+                .score = score,
+            });
+        }
+    }
+    catch (const Ort::Exception& e) {
+        LogError << "onnxruntime error" << VAR(param_.model) << VAR(e.what());
+        return {};
+    }
+
+    return NMS(std::move(results), DetectorParam::kDefaultNMSThreshold);
+}
+
+void Detector::draw_result(const ResultsVec& results) const
+{
+    cv::Mat image_draw = image_.clone();
+    const auto color = cv::Scalar(0, 0, 255);
+    cv::putText(image_draw, name_, cv::Point(5, image_.rows - 5), cv::FONT_HERSHEY_SIMPLEX, 1, color, 2);
+
+    for (const Result& res : results) {
+        cv::rectangle(image_draw, res.box, color, 1);
+        std::string flag = MAA_FMT::format("{} {}: {:.3f}", res.cls_index, res.label, res.score);
+        cv::putText(image_draw, flag, cv::Point(res.box.x, res.box.y - 5), cv::FONT_HERSHEY_PLAIN, 1.2, color, 1);
+    }
+
+    if (save_draw_) {
+        save_image(image_draw);
+    }
+}
+
+bool Detector::filter_by_expected(const Result& res) const
+{
+    if (param_.expected_indices.empty()) {
+        return true;
+    }
+
+    return MAA_RNS::ranges::find(param_.expected_indices, res.cls_index) != param_.expected_indices.end();
+}
+
+MAA_VISION_NS_END
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "VisionBase.h"
+
+#include <optional>
+#include <vector>
+
+#include "VisionTypes.h"
+
+MAA_VISION_NS_BEGIN
+
+class Detector : public VisionBase
+{
+public:
+    struct Result
+    {
+        size_t cls_index = SIZE_MAX;
+        std::string label;
+        cv::Rect box {};
+        double score = 0.0;
+    };
+
+    using ResultsVec = std::vector<Result>;
+    using ResultOpt = std::optional<ResultsVec>;
+
+public:
+    using VisionBase::VisionBase;
+
+    void set_param(DetectorParam param) { param_ = std::move(param); }
+    ResultOpt analyze() const;
+
+private:
+    ResultsVec traverse_rois() const;
+    ResultsVec predict(const cv::Rect& roi) const;
+    void draw_result(const ResultsVec& results) const;
+    bool filter_by_expected(const Result& res) const;
+
+    DetectorParam param_;
+};
+
+MAA_VISION_NS_END
+
+std::ostream& operator<<(std::ostream& os, const MAA_VISION_NS::Detector::Result& res);
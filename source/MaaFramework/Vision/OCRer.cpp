@@ -7,6 +7,7 @@
 #include "Utils/Logger.h"
 #include "Utils/Ranges.hpp"
 #include "Utils/StringMisc.hpp"
+#include "VisionUtils.hpp"
 
 MAA_VISION_NS_BEGIN
 
@@ -74,14 +75,68 @@ OCRer::ResultsVec OCRer::predict_det_and_rec(const cv::Rect& roi) const
         return {};
     }
 
+    auto start_time = std::chrono::steady_clock::now();
+
+    auto image_roi = image_with_roi(roi);
+
+    const std::string track_key = MAA_FMT::format("{}_{}_{}_{}_{}", name_, roi.x, roi.y, roi.width, roi.height);
+    const OcrTrackCache* track_cache = status() ? status()->get_ocr_track_cache(track_key) : nullptr;
+    const size_t roi_hash = image_hash(image_roi);
+
+    ResultsVec results;
+    if (track_cache && track_cache->roi_hash == roi_hash) {
+        // roi 内完全没变，检测和识别都可以跳过
+        for (const auto& line : track_cache->lines) {
+            results.emplace_back(Result { .text = line.text, .box = line.box, .score = line.score });
+        }
+        LogDebug << "roi unchanged, reuse tracked lines" << VAR(track_key);
+    }
+    else if (status() || det_scale(image_roi) < 1.0) {
+        // 需要跟踪或单独跑检测时，检测和识别分开进行。首帧也走这条路，
+        // 否则 PPOCR 按批识别（批内补齐宽度）的结果和之后逐行识别的不一样，同一行文字会前后不一致
+        results = det_then_rec(image_roi, roi, track_cache);
+    }
+    else {
+        results = det_and_rec_all(image_roi, roi);
+    }
+
+    if (status()) {
+        OcrTrackCache new_cache { .roi_hash = roi_hash };
+        for (const auto& res : results) {
+            new_cache.lines.emplace_back(OcrTrackCache::Line {
+                .box = res.box, .hash = image_hash(image_with_roi(res.box)), .text = res.text, .score = res.score });
+        }
+        status()->set_ocr_track_cache(track_key, std::move(new_cache));
+    }
+
+    if (debug_draw_) {
+        cv::Mat image_draw = draw_roi(roi);
+        const auto color = cv::Scalar(0, 0, 255);
+        for (size_t i = 0; i != results.size(); ++i) {
+            const cv::Rect& my_box = results.at(i).box;
+            cv::rectangle(image_draw, my_box, color, 1);
+            std::string flag =
+                MAA_FMT::format("{}: [{}, {}, {}, {}]", i, my_box.x, my_box.y, my_box.width, my_box.height);
+            cv::putText(image_draw, flag, cv::Point(my_box.x, my_box.y - 5), cv::FONT_HERSHEY_PLAIN, 1.2, color, 1);
+        }
+        if (save_draw_) {
+            save_image(image_draw);
+        }
+    }
+
+    auto costs = duration_since(start_time);
+    LogDebug << VAR(results) << VAR(image_roi.size()) << VAR(costs);
+
+    return results;
+}
+
+OCRer::ResultsVec OCRer::det_and_rec_all(const cv::Mat& image_roi, const cv::Rect& roi) const
+{
     auto& inferencer = resource()->ocr_cfg().ocrer();
     if (!inferencer) {
         LogError << "resource()->ocr_cfg().ocrer() is null";
         return {};
     }
-    auto start_time = std::chrono::steady_clock::now();
-
-    auto image_roi = image_with_roi(roi);
 
     fastdeploy::vision::OCRResult ocr_result;
     bool ret = inferencer->Predict(image_roi, &ocr_result);
@@ -97,44 +152,147 @@ OCRer::ResultsVec OCRer::predict_det_and_rec(const cv::Rect& roi) const
     }
 
     ResultsVec results;
-
-    cv::Mat image_draw;
-    if (debug_draw_) {
-        image_draw = draw_roi(roi);
-    }
-
     for (size_t i = 0; i != ocr_result.text.size(); ++i) {
-        // the raw_box rect like ↓
-        // 0 - 1
-        // 3 - 2
-        const auto& raw_box = ocr_result.boxes.at(i);
-        int x_collect[] = { raw_box[0], raw_box[2], raw_box[4], raw_box[6] };
-        int y_collect[] = { raw_box[1], raw_box[3], raw_box[5], raw_box[7] };
-        auto [left, right] = MAA_RNS::ranges::minmax(x_collect);
-        auto [top, bottom] = MAA_RNS::ranges::minmax(y_collect);
-
-        cv::Rect my_box(left + roi.x, top + roi.y, right - left, bottom - top);
-        if (debug_draw_) {
-            const auto color = cv::Scalar(0, 0, 255);
-            cv::rectangle(image_draw, my_box, color, 1);
-            std::string flag =
-                MAA_FMT::format("{}: [{}, {}, {}, {}]", i, my_box.x, my_box.y, my_box.width, my_box.height);
-            cv::putText(image_draw, flag, cv::Point(my_box.x, my_box.y - 5), cv::FONT_HERSHEY_PLAIN, 1.2, color, 1);
-        }
+        cv::Rect my_box = quad_to_rect(ocr_result.boxes.at(i), roi);
         results.emplace_back(
             Result { .text = std::move(ocr_result.text.at(i)), .box = my_box, .score = ocr_result.rec_scores.at(i) });
     }
+    return results;
+}
 
-    auto costs = duration_since(start_time);
-    LogDebug << VAR(results) << VAR(image_roi.size()) << VAR(costs);
+OCRer::ResultsVec OCRer::det_then_rec(const cv::Mat& image_roi, const cv::Rect& roi,
+                                      const OcrTrackCache* track_cache) const
+{
+    auto& deter = resource()->ocr_cfg().deter();
+    auto& recer = resource()->ocr_cfg().recer();
+    if (!deter || !recer) {
+        LogError << "resource()->ocr_cfg().deter() or recer() is null";
+        return {};
+    }
 
-    if (save_draw_) {
-        save_image(image_draw);
+    const double scale = det_scale(image_roi);
+    cv::Mat det_image = image_roi;
+    if (scale < 1.0) {
+        cv::resize(image_roi, det_image, cv::Size(), scale, scale, cv::INTER_AREA);
+    }
+
+    std::vector<std::array<int, 8>> boxes;
+    bool ret = deter->Predict(det_image, &boxes);
+    if (!ret) {
+        LogWarn << "deter return false" << VAR(deter) << VAR(image_) << VAR(roi) << VAR(det_image.size());
+        return {};
     }
 
+    ResultsVec results;
+    size_t reused = 0;
+    for (const auto& raw_box : boxes) {
+        cv::Rect my_box = quad_to_rect(raw_box, roi, scale);
+        cv::Mat line_image = image_with_roi(my_box);
+
+        if (track_cache) {
+            size_t line_hash = image_hash(line_image);
+            auto cached = MAA_RNS::ranges::find_if(track_cache->lines, [&](const OcrTrackCache::Line& line) {
+                return line.hash == line_hash && line.box.size() == my_box.size();
+            });
+            if (cached != track_cache->lines.end()) {
+                results.emplace_back(Result { .text = cached->text, .box = my_box, .score = cached->score });
+                ++reused;
+                continue;
+            }
+        }
+
+        // 缓存按外接矩形判断是否变化，识别则和 PPOCR 一样用摆正后的四边形区域
+        cv::Mat rec_image = rotate_crop(image_roi, raw_box, scale);
+        if (rec_image.empty()) {
+            continue;
+        }
+
+        std::string rec_text;
+        float rec_score = 0;
+        if (!recer->Predict(rec_image, &rec_text, &rec_score)) {
+            LogWarn << "recer return false" << VAR(recer) << VAR(my_box);
+            continue;
+        }
+        results.emplace_back(Result { .text = std::move(rec_text), .box = my_box, .score = rec_score });
+    }
+
+    // 与 PPOCR 的输出顺序保持一致：从上到下，同一行从左到右
+    MAA_RNS::ranges::stable_sort(results, [](const Result& lhs, const Result& rhs) {
+        return std::abs(lhs.box.y - rhs.box.y) < 10 ? lhs.box.x < rhs.box.x : lhs.box.y < rhs.box.y;
+    });
+
+    LogDebug << VAR(boxes.size()) << VAR(reused) << VAR(scale);
+
     return results;
 }
 
+double OCRer::det_scale(const cv::Mat& image_roi) const
+{
+    double scale = param_.det_scale;
+
+    const int long_side = std::max(image_roi.cols, image_roi.rows);
+    if (param_.det_max_side > 0 && long_side > param_.det_max_side) {
+        scale = std::min(scale, static_cast<double>(param_.det_max_side) / long_side);
+    }
+    return scale;
+}
+
+cv::Rect OCRer::quad_to_rect(const std::array<int, 8>& raw_box, const cv::Rect& roi, double scale)
+{
+    // the raw_box rect like ↓
+    // 0 - 1
+    // 3 - 2
+    int x_collect[] = { raw_box[0], raw_box[2], raw_box[4], raw_box[6] };
+    int y_collect[] = { raw_box[1], raw_box[3], raw_box[5], raw_box[7] };
+    auto [left, right] = MAA_RNS::ranges::minmax(x_collect);
+    auto [top, bottom] = MAA_RNS::ranges::minmax(y_collect);
+
+    // 检测图可能被缩小过，映射回 roi 坐标
+    int x = static_cast<int>(left / scale);
+    int y = static_cast<int>(top / scale);
+    int width = static_cast<int>(std::ceil(right / scale)) - x;
+    int height = static_cast<int>(std::ceil(bottom / scale)) - y;
+
+    return cv::Rect(x + roi.x, y + roi.y, width, height);
+}
+
+cv::Mat OCRer::rotate_crop(const cv::Mat& image_roi, const std::array<int, 8>& raw_box, double scale)
+{
+    // 同 fastdeploy 的 GetRotateCropImage：先取外接矩形，再透视变换成水平的一行，竖排的转 90 度
+    cv::Rect bounding = quad_to_rect(raw_box, cv::Rect {}, scale) & cv::Rect(0, 0, image_roi.cols, image_roi.rows);
+    if (bounding.empty()) {
+        return {};
+    }
+
+    std::array<cv::Point2f, 4> points;
+    for (size_t i = 0; i != points.size(); ++i) {
+        points[i] = cv::Point2f(static_cast<float>(raw_box[i * 2] / scale - bounding.x),
+                                static_cast<float>(raw_box[i * 2 + 1] / scale - bounding.y));
+    }
+
+    const int width = static_cast<int>(cv::norm(points[0] - points[1]));
+    const int height = static_cast<int>(cv::norm(points[0] - points[3]));
+    if (width <= 0 || height <= 0) {
+        return {};
+    }
+
+    const std::array<cv::Point2f, 4> dst_points = {
+        cv::Point2f(0, 0),
+        cv::Point2f(static_cast<float>(width), 0),
+        cv::Point2f(static_cast<float>(width), static_cast<float>(height)),
+        cv::Point2f(0, static_cast<float>(height)),
+    };
+    cv::Mat transform = cv::getPerspectiveTransform(points.data(), dst_points.data());
+
+    cv::Mat line;
+    cv::warpPerspective(image_roi(bounding), line, transform, cv::Size(width, height), cv::INTER_LINEAR);
+
+    if (line.rows >= line.cols * 1.5) {
+        cv::rotate(line, line, cv::ROTATE_90_COUNTERCLOCKWISE);
+    }
+    return line;
+}
+
 OCRer::Result OCRer::predict_only_rec(const cv::Rect& roi) const
 {
     if (!resource()) {
@@ -2,6 +2,7 @@
 
 #include "VisionBase.h"
 
+#include <array>
 #include <optional>
 #include <vector>
 
@@ -32,11 +33,17 @@ private:
     ResultsVec traverse_rois() const;
     ResultsVec predict(const cv::Rect& roi) const;
     ResultsVec predict_det_and_rec(const cv::Rect& roi) const;
+    ResultsVec det_and_rec_all(const cv::Mat& image_roi, const cv::Rect& roi) const;
+    ResultsVec det_then_rec(const cv::Mat& image_roi, const cv::Rect& roi, const OcrTrackCache* track_cache) const;
+    double det_scale(const cv::Mat& image_roi) const;
     Result predict_only_rec(const cv::Rect& roi) const;
     void postproc_trim_(Result& res) const;
     void postproc_replace_(Result& res) const;
     bool filter_by_required(const Result& res) const;
 
+    static cv::Rect quad_to_rect(const std::array<int, 8>& raw_box, const cv::Rect& roi, double scale = 1.0);
+    static cv::Mat rotate_crop(const cv::Mat& image_roi, const std::array<int, 8>& raw_box, double scale);
+
     OcrParam param_;
 };
 
@@ -34,6 +34,46 @@ struct OcrParam
     std::vector<cv::Rect> roi;
     std::vector<std::string> text;
     std::vector<std::pair<std::string, std::string>> replace;
+
+    // 仅作用于检测，识别仍使用原图截取的文字行
+    int det_max_side = 0; // 0 表示不限制
+    double det_scale = 1.0;
+};
+
+// 上一帧的检测框及其截图哈希，用于跨帧复用识别结果
+struct OcrTrackCache
+{
+    struct Line
+    {
+        cv::Rect box {};
+        size_t hash = 0;
+        std::string text;
+        double score = 0.0;
+    };
+
+    size_t roi_hash = 0;
+    std::vector<Line> lines;
+};
+
+struct ClassifierParam
+{
+    std::vector<cv::Rect> roi;
+    std::string model;
+    std::vector<std::string> labels;
+    std::vector<size_t> expected;
+};
+
+struct DetectorParam
+{
+    inline static constexpr double kDefaultThreshold = 0.3;
+    inline static constexpr double kDefaultNMSThreshold = 0.45;
+
+    std::vector<cv::Rect> roi;
+    std::string model;
+    std::vector<std::string> labels;
+    std::vector<std::string> expected;
+    std::vector<size_t> expected_indices;
+    double threshold = kDefaultThreshold;
 };
 
 struct CompParam
@@ -45,6 +85,7 @@ struct CompParam
 
 struct CustomParam
 {
+    std::vector<cv::Rect> roi;
     std::string name;
     json::value custom_param;
 };
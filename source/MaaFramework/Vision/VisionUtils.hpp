@@ -1,5 +1,9 @@
 #pragma once
 
+#include <functional>
+#include <string_view>
+#include <vector>
+
 #include "Conf/Conf.h"
 #include "Utils/Logger.h"
 #include "Utils/NoWarningCV.hpp"
@@ -63,21 +67,24 @@ inline static ResultsVec NMS(ResultsVec results, double threshold = 0.7)
 {
     MAA_RNS::ranges::sort(results, [](const auto& a, const auto& b) { return a.score > b.score; });
 
+    // 只做抑制，不按分数过滤：低分的框由调用方按自己的阈值先筛掉
     ResultsVec nms_results;
+    std::vector<bool> suppressed(results.size(), false);
     for (size_t i = 0; i < results.size(); ++i) {
-        const auto& box = results[i];
-        if (box.score < 0.1f) {
+        if (suppressed[i]) {
             continue;
         }
+        const auto& box = results[i];
         nms_results.emplace_back(box);
         for (size_t j = i + 1; j < results.size(); ++j) {
-            auto& box2 = results[j];
-            if (box2.score < 0.1f) {
+            if (suppressed[j]) {
                 continue;
             }
-            int iou_area = (make_rect<cv::Rect>(box.rect) & make_rect<cv::Rect>(box2.rect)).area();
-            if (iou_area > threshold * box2.rect.area()) {
-                box2.score = 0;
+            const auto& box2 = results[j];
+            int inter_area = (box.box & box2.box).area();
+            int union_area = box.box.area() + box2.box.area() - inter_area;
+            if (union_area > 0 && inter_area > threshold * union_area) {
+                suppressed[j] = true;
             }
         }
     }
@@ -100,37 +107,66 @@ inline static T softmax(const T& input)
     return output;
 }
 
-inline static cv::Mat hwc_to_chw(const cv::Mat& src)
+// 逐行哈希，只用于判断两张图是否完全一致
+inline static size_t image_hash(const cv::Mat& image)
+{
+    size_t seed =
+        std::hash<int> {}(image.rows) ^ (std::hash<int> {}(image.cols) << 1) ^ static_cast<size_t>(image.type());
+
+    const size_t row_bytes = image.cols * image.elemSize();
+    for (int y = 0; y != image.rows; ++y) {
+        std::string_view row(reinterpret_cast<const char*>(image.ptr(y)), row_bytes);
+        seed ^= std::hash<std::string_view> {}(row) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+// BGR8 HWC -> RGB float CHW / 255, 单次遍历; tensor 需至少有 3 * rows * cols 个元素
+inline static bool image_to_tensor(const cv::Mat& image, float* tensor)
 {
-    std::vector<cv::Mat> rgb_images;
-    cv::split(src, rgb_images);
+    if (image.empty() || image.type() != CV_8UC3) {
+        LogError << "image type is not CV_8UC3" << VAR(image.size()) << VAR(image.type());
+        return false;
+    }
+
+    const int rows = image.rows;
+    const int cols = image.cols;
+    const size_t plane_size = static_cast<size_t>(rows) * cols;
 
-    // Stretch one-channel images to vector
-    cv::Mat flat_r = rgb_images[0].reshape(1, 1);
-    cv::Mat flat_g = rgb_images[1].reshape(1, 1);
-    cv::Mat flat_b = rgb_images[2].reshape(1, 1);
+    float* __restrict r_plane = tensor;
+    float* __restrict g_plane = r_plane + plane_size;
+    float* __restrict b_plane = g_plane + plane_size;
 
-    // Now we can rearrange channels if need
-    cv::Mat matArray[] = { flat_r, flat_g, flat_b };
+    constexpr float kNormScale = 1.0f / 255.0f;
 
-    cv::Mat flat_image;
-    // Concatenate three vectors to one
-    cv::hconcat(matArray, 3, flat_image);
-    return flat_image;
+    for (int y = 0; y != rows; ++y) {
+        const uchar* __restrict src = image.ptr<uchar>(y);
+        const size_t offset = static_cast<size_t>(y) * cols;
+        float* __restrict r = r_plane + offset;
+        float* __restrict g = g_plane + offset;
+        float* __restrict b = b_plane + offset;
+
+        for (int x = 0; x != cols; ++x) {
+            b[x] = src[3 * x] * kNormScale;
+            g[x] = src[3 * x + 1] * kNormScale;
+            r[x] = src[3 * x + 2] * kNormScale;
+        }
+    }
+
+    return true;
 }
 
-inline static std::vector<float> image_to_tensor(const cv::Mat& image)
+// tensor 可跨帧复用, 避免重复分配
+inline static bool image_to_tensor(const cv::Mat& image, std::vector<float>& tensor)
 {
-    cv::Mat src = image.clone();
-    cv::cvtColor(src, src, cv::COLOR_BGR2RGB);
-
-    cv::Mat chw = hwc_to_chw(src);
-    cv::Mat chw_32f;
-    chw.convertTo(chw_32f, CV_32F, 1.0 / 255.0);
+    tensor.resize(static_cast<size_t>(image.rows) * image.cols * 3);
+    return image_to_tensor(image, tensor.data());
+}
 
-    size_t tensor_size = 1ULL * src.cols * src.rows * src.channels();
-    std::vector<float> tensor(tensor_size);
-    std::memcpy(tensor.data(), chw_32f.data, tensor_size * sizeof(float));
+inline static std::vector<float> image_to_tensor(const cv::Mat& image)
+{
+    std::vector<float> tensor;
+    image_to_tensor(image, tensor);
     return tensor;
 }
 
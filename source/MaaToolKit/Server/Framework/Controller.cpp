@@ -117,6 +117,14 @@ auto cfg = R"({
             "tcp:{FOWARD_PORT}",
             "localabstract:{LOCAL_SOCKET}"
         ],
+        "ForwardTcp": [
+            "{ADB}",
+            "-s",
+            "{ADB_SERIAL}",
+            "forward",
+            "tcp:{FOWARD_PORT}",
+            "tcp:{REMOTE_PORT}"
+        ],
         "NetcatAddress": [
             "{ADB}",
             "-s",
@@ -138,6 +146,20 @@ auto cfg = R"({
             "exec-out",
             "screencap | gzip -1"
         ],
+        "ScreencapRawStream": [
+            "{ADB}",
+            "-s",
+            "{ADB_SERIAL}",
+            "shell",
+            "while true; do echo -n MAAFRAME; screencap; done | nc -l -p {REMOTE_PORT}"
+        ],
+        "ScreencapVideoStream": [
+            "{ADB}",
+            "-s",
+            "{ADB_SERIAL}",
+            "shell",
+            "while true; do screenrecord --output-format=h264 -; done | nc -l -p {REMOTE_PORT}"
+        ],
         "ScreencapEncode": [
             "{ADB}",
             "-s",
@@ -259,6 +281,8 @@ void init_maa_framework_controller(ApiDispatcher& disp)
                     { "screencap.encodetofile", MaaAdbControllerType_Screencap_EncodeToFile },
                     { "screencap.minicapdirect", MaaAdbControllerType_Screencap_MinicapDirect },
                     { "screencap.minicapstream", MaaAdbControllerType_Screencap_MinicapStream },
+                    { "screencap.rawstream", MaaAdbControllerType_Screencap_RawStream },
+                    { "screencap.videostream", MaaAdbControllerType_Screencap_VideoStream },
                 };
 
                 auto adb = require_key_as_string(obj, "adb");
@@ -2,8 +2,15 @@
 
 #include "Utils/Platform.h"
 
+#include <atomic>
+
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
+#include "Utils/Format.hpp"
+#include "Utils/Logger.h"
+
 MAA_NS_BEGIN
 
 os_string to_osstring(std::string_view utf8_str)
@@ -46,6 +53,49 @@ void aligned_free(void* ptr)
     ::free(ptr);
 }
 
+std::unique_ptr<shared_memory> shared_memory::create(size_t size)
+{
+    static std::atomic_int counter = 0;
+    // macOS 上名字不能超过 31 个字符
+    std::string name = MAA_FMT::format("/maa-{}-{}", getpid(), ++counter);
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        LogError << "shm_open failed" << VAR(name) << VAR(errno);
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        LogError << "ftruncate failed" << VAR(name) << VAR(size) << VAR(errno);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // 映射建立后 fd 就用不到了
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        LogError << "mmap failed" << VAR(name) << VAR(size) << VAR(errno);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<shared_memory> shm(new shared_memory);
+    shm->data_ = data;
+    shm->size_ = size;
+    shm->name_ = std::move(name);
+    return shm;
+}
+
+shared_memory::~shared_memory()
+{
+    if (data_) {
+        munmap(data_, size_);
+    }
+    if (!name_.empty()) {
+        shm_unlink(name_.c_str());
+    }
+}
+
 MAA_NS_END
 
 #endif
@@ -3,9 +3,12 @@
 
 #include "Utils/SafeWindows.hpp"
 
+#include <atomic>
+
 #include <Psapi.h>
 #include <mbctype.h>
 
+#include "Utils/Format.hpp"
 #include "Utils/Platform.h"
 #include "Utils/Logger.h"
 
@@ -284,6 +287,47 @@ void aligned_free(void* ptr)
     _aligned_free(ptr);
 }
 
+std::unique_ptr<shared_memory> shared_memory::create(size_t size)
+{
+    static std::atomic_int counter = 0;
+    std::string name = MAA_FMT::format("Local\\maa-{}-{}", GetCurrentProcessId(), ++counter);
+
+    // 分页文件支持的映射，最后一个句柄关闭时自动释放，不需要单独删除名字
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                        static_cast<DWORD>(size & 0xFFFFFFFF), to_osstring(name).c_str());
+    if (!mapping || GetLastError() == ERROR_ALREADY_EXISTS) {
+        LogError << "CreateFileMappingW failed" << VAR(name) << VAR(size) << VAR(GetLastError());
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        return nullptr;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!data) {
+        LogError << "MapViewOfFile failed" << VAR(name) << VAR(size) << VAR(GetLastError());
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    std::unique_ptr<shared_memory> shm(new shared_memory);
+    shm->data_ = data;
+    shm->size_ = size;
+    shm->name_ = std::move(name);
+    shm->mapping_ = mapping;
+    return shm;
+}
+
+shared_memory::~shared_memory()
+{
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+}
+
 MAA_NS_END
 
 #endif
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <optional>
 
@@ -69,6 +70,8 @@ public:
 
     virtual bool click(int x, int y) = 0;
     virtual bool swipe(const std::vector<SwipeStep>& steps) = 0;
+    // 手势可能整段交给设备端执行后就返回，这里给出设备端预计做完的时间
+    virtual std::chrono::steady_clock::time_point gesture_end() const = 0;
 };
 
 class KeyInputAPI
@@ -87,8 +90,12 @@ public:
     virtual ~ScreencapAPI() = default;
 
     virtual bool init(int swidth, int sheight) = 0;
+    // init 成功后、第一次截图前调用。测速之类的准备会被同时进行的其他初始化拖慢，所以和 init 分开，等别的都初始化完再做
+    virtual bool prepare() = 0;
     virtual void deinit() = 0;
     virtual void set_wh(int swidth, int sheight) = 0;
+    // 控制器最终需要的图像尺寸，0 表示未知。仅作为解码提示，screencap 返回的图像不保证是该尺寸
+    virtual void set_target_size(int twidth, int theight) = 0;
 
     virtual std::optional<cv::Mat> screencap() = 0;
 };
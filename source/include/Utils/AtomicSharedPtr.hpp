@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "Conf/Conf.h"
+
+MAA_NS_BEGIN
+
+// std::atomic<std::shared_ptr> 还不是所有标准库都有（比如 libc++），没有的话退化成加锁
+template <typename T>
+class AtomicSharedPtr
+{
+public:
+    AtomicSharedPtr() = default;
+    AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+    AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::shared_ptr<T> load() const { return ptr_.load(std::memory_order_acquire); }
+    void store(std::shared_ptr<T> ptr) { ptr_.store(std::move(ptr), std::memory_order_release); }
+
+private:
+    std::atomic<std::shared_ptr<T>> ptr_;
+#else
+    std::shared_ptr<T> load() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return ptr_;
+    }
+    void store(std::shared_ptr<T> ptr)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ptr_.swap(ptr);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<T> ptr_;
+#endif
+};
+
+MAA_NS_END
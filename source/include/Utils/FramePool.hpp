@@ -0,0 +1,63 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "NoWarningCVMat.hpp"
+
+MAA_NS_BEGIN
+
+// 复用截图的图像内存。
+// 分配出去的 Mat 与池共享数据，只有在外部不再引用（refcount 回到 1）时才会被再次分配，
+// 所以拿到的 Mat 在释放前不会被改写；使用方应把它当作只读，需要修改时自行 clone
+class FramePool
+{
+public:
+    explicit FramePool(size_t capacity = 4) : capacity_(capacity) {}
+
+    cv::Mat acquire(int rows, int cols, int type)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        cv::Mat* idle_other = nullptr;
+        for (cv::Mat& buffer : buffers_) {
+            if (!idle(buffer)) {
+                continue;
+            }
+            if (buffer.rows == rows && buffer.cols == cols && buffer.type() == type) {
+                return buffer;
+            }
+            idle_other = &buffer;
+        }
+
+        cv::Mat fresh(rows, cols, type);
+        if (buffers_.size() < capacity_) {
+            buffers_.emplace_back(fresh);
+        }
+        else if (idle_other) {
+            // 尺寸变了（比如改了目标分辨率），旧的让位
+            *idle_other = fresh;
+        }
+        // 都在被使用，就不进池了
+        return fresh;
+    }
+
+    void clear()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffers_.clear();
+    }
+
+private:
+    static bool idle(const cv::Mat& buffer)
+    {
+        // 只有池自己持有；此时外部拿不到它，引用计数不会在检查后增加
+        return buffer.u && CV_XADD(&buffer.u->refcount, 0) == 1;
+    }
+
+    const size_t capacity_ = 0;
+    std::mutex mutex_;
+    std::vector<cv::Mat> buffers_;
+};
+
+MAA_NS_END
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Utils/Logger.h"
+#include "Utils/Time.hpp"
+
+MAA_NS_BEGIN
+
+// 按依赖关系执行初始化步骤：互不依赖的步骤并发执行，某一步失败后，依赖它的步骤不再执行。
+// 每一步在自己的线程里跑，适合数量不多、主要在等 IO 的步骤
+class InitScheduler
+{
+public:
+    using Step = std::function<bool()>;
+
+    struct StepReport
+    {
+        std::string name;
+        bool executed = false;
+        bool success = false;
+        // 相对 run 开始的时间
+        std::chrono::milliseconds start {};
+        std::chrono::milliseconds cost {};
+    };
+
+public:
+    // 依赖的步骤必须已经添加过，所以不会成环
+    bool add(std::string name, Step step, const std::vector<std::string>& deps = {})
+    {
+        if (index_.contains(name)) {
+            LogError << "duplicate step" << VAR(name);
+            return false;
+        }
+
+        std::vector<size_t> dep_indices;
+        for (const auto& dep : deps) {
+            auto iter = index_.find(dep);
+            if (iter == index_.end()) {
+                LogError << "unknown dependency" << VAR(name) << VAR(dep);
+                return false;
+            }
+            dep_indices.emplace_back(iter->second);
+        }
+
+        index_.emplace(name, nodes_.size());
+        nodes_.emplace_back(Node { .name = std::move(name), .step = std::move(step), .deps = std::move(dep_indices) });
+        return true;
+    }
+
+    // 所有步骤都成功时返回 true
+    bool run()
+    {
+        LogFunc << VAR(nodes_.size());
+
+        const auto start_time = std::chrono::steady_clock::now();
+        report_.assign(nodes_.size(), StepReport {});
+
+        std::vector<std::shared_future<bool>> results;
+        results.reserve(nodes_.size());
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            std::vector<std::shared_future<bool>> deps;
+            for (size_t dep : nodes_[i].deps) {
+                deps.emplace_back(results[dep]);
+            }
+            results.emplace_back(
+                std::async(std::launch::async, [this, i, deps = std::move(deps), start_time]() {
+                    return run_step(i, deps, start_time);
+                }).share());
+        }
+
+        bool ret = true;
+        for (auto& result : results) {
+            ret &= result.get();
+        }
+        total_ = duration_since(start_time);
+
+        for (const auto& report : report_) {
+            LogInfo << VAR(report.name) << VAR(report.executed) << VAR(report.success) << VAR(report.start)
+                    << VAR(report.cost);
+        }
+        LogInfo << VAR(ret) << VAR(total_);
+        return ret;
+    }
+
+    bool succeeded(const std::string& name) const
+    {
+        auto iter = index_.find(name);
+        return iter != index_.end() && iter->second < report_.size() && report_[iter->second].success;
+    }
+
+    // 按添加顺序
+    const std::vector<StepReport>& report() const { return report_; }
+    std::chrono::milliseconds total() const { return total_; }
+
+private:
+    struct Node
+    {
+        std::string name;
+        Step step;
+        std::vector<size_t> deps;
+    };
+
+    bool run_step(size_t i, const std::vector<std::shared_future<bool>>& deps,
+                  std::chrono::steady_clock::time_point start_time)
+    {
+        auto& report = report_[i];
+        report.name = nodes_[i].name;
+
+        bool deps_ok = std::ranges::all_of(deps, [](const auto& dep) { return dep.get(); });
+        if (!deps_ok) {
+            LogWarn << "dependency failed, skip" << VAR(report.name);
+            return false;
+        }
+
+        auto step_start = std::chrono::steady_clock::now();
+        report.start = std::chrono::duration_cast<std::chrono::milliseconds>(step_start - start_time);
+        report.executed = true;
+        try {
+            report.success = nodes_[i].step();
+        }
+        catch (const std::exception& e) {
+            LogError << "step throws" << VAR(report.name) << VAR(e.what());
+            report.success = false;
+        }
+        report.cost = duration_since(step_start);
+        return report.success;
+    }
+
+    std::vector<Node> nodes_;
+    std::map<std::string, size_t> index_;
+
+    std::vector<StepReport> report_;
+    std::chrono::milliseconds total_ {};
+};
+
+MAA_NS_END
@@ -3,6 +3,7 @@
 #include "Conf/Conf.h"
 
 #include <filesystem>
+#include <memory>
 #include <ostream>
 #include <set>
 #include <string>
@@ -116,4 +117,31 @@ private:
     TElem* _ptr = nullptr;
 };
 
+/* shared memory */
+
+// 具名的匿名共享内存，名字交给同机的另一个进程去打开映射；析构时解除映射，名字也随之删除
+class MAA_UTILS_API shared_memory
+{
+public:
+    static std::unique_ptr<shared_memory> create(size_t size);
+    ~shared_memory();
+
+    shared_memory(const shared_memory&) = delete;
+    shared_memory& operator=(const shared_memory&) = delete;
+
+    inline void* data() const { return data_; }
+    inline size_t size() const { return size_; }
+    inline const std::string& name() const { return name_; }
+
+private:
+    shared_memory() = default;
+
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    std::string name_;
+#ifdef _WIN32
+    HANDLE mapping_ = nullptr;
+#endif
+};
+
 MAA_NS_END
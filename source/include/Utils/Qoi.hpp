@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "NoWarningCVMat.hpp"
+
+MAA_NS_BEGIN
+
+// QOI (https://qoiformat.org) 编码，无损，比 png 快一个数量级，压缩率略差。
+// 只接受 CV_8UC3 的 BGR 图，输出 3 通道 sRGB
+inline std::vector<uint8_t> encode_qoi(const cv::Mat& bgr)
+{
+    // alpha 也要参与比较和哈希：解码器的 index 初始全为 0（alpha 也是 0），与 alpha 为 255 的黑色不相等
+    struct Pixel
+    {
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+        uint8_t a;
+
+        bool operator==(const Pixel&) const = default;
+    };
+
+    if (bgr.empty() || bgr.type() != CV_8UC3) {
+        return {};
+    }
+
+    const uint32_t width = static_cast<uint32_t>(bgr.cols);
+    const uint32_t height = static_cast<uint32_t>(bgr.rows);
+
+    std::vector<uint8_t> out;
+    // 最坏情况每个像素 4 字节，加上 14 字节头和 8 字节结尾
+    out.reserve(static_cast<size_t>(width) * height * 4 + 22);
+
+    auto push_u32 = [&](uint32_t v) {
+        out.emplace_back(static_cast<uint8_t>(v >> 24));
+        out.emplace_back(static_cast<uint8_t>(v >> 16));
+        out.emplace_back(static_cast<uint8_t>(v >> 8));
+        out.emplace_back(static_cast<uint8_t>(v));
+    };
+    out.insert(out.end(), { 'q', 'o', 'i', 'f' });
+    push_u32(width);
+    push_u32(height);
+    out.emplace_back(static_cast<uint8_t>(3)); // channels
+    out.emplace_back(static_cast<uint8_t>(0)); // sRGB with linear alpha
+
+    constexpr uint8_t kOpIndex = 0x00;
+    constexpr uint8_t kOpDiff = 0x40;
+    constexpr uint8_t kOpLuma = 0x80;
+    constexpr uint8_t kOpRun = 0xc0;
+    constexpr uint8_t kOpRgb = 0xfe;
+    constexpr int kMaxRun = 62;
+
+    auto hash = [](const Pixel& px) { return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64; };
+
+    std::array<Pixel, 64> index {};
+    Pixel prev { .r = 0, .g = 0, .b = 0, .a = 255 };
+    int run = 0;
+
+    for (int y = 0; y < bgr.rows; ++y) {
+        const uint8_t* row = bgr.ptr<uint8_t>(y);
+        for (int x = 0; x < bgr.cols; ++x) {
+            const Pixel px { .r = row[x * 3 + 2], .g = row[x * 3 + 1], .b = row[x * 3], .a = 255 };
+
+            if (px == prev) {
+                if (++run == kMaxRun) {
+                    out.emplace_back(static_cast<uint8_t>(kOpRun | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                out.emplace_back(static_cast<uint8_t>(kOpRun | (run - 1)));
+                run = 0;
+            }
+
+            const int pos = hash(px);
+            if (index[pos] == px) {
+                out.emplace_back(static_cast<uint8_t>(kOpIndex | pos));
+                prev = px;
+                continue;
+            }
+            index[pos] = px;
+
+            const int vr = static_cast<int8_t>(px.r - prev.r);
+            const int vg = static_cast<int8_t>(px.g - prev.g);
+            const int vb = static_cast<int8_t>(px.b - prev.b);
+            const int vg_r = vr - vg;
+            const int vg_b = vb - vg;
+
+            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                out.emplace_back(static_cast<uint8_t>(kOpDiff | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+            }
+            else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                out.emplace_back(static_cast<uint8_t>(kOpLuma | (vg + 32)));
+                out.emplace_back(static_cast<uint8_t>((vg_r + 8) << 4 | (vg_b + 8)));
+            }
+            else {
+                out.insert(out.end(), { kOpRgb, px.r, px.g, px.b });
+            }
+            prev = px;
+        }
+    }
+    if (run > 0) {
+        out.emplace_back(static_cast<uint8_t>(kOpRun | (run - 1)));
+    }
+
+    out.insert(out.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+    return out;
+}
+
+MAA_NS_END
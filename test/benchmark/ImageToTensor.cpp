@@ -0,0 +1,100 @@
+// image_to_tensor 新旧实现的对比：结果是否一致、每次调用的耗时
+// 用法: ImageToTensorBenchmark [width] [height] [loops]
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Vision/VisionUtils.hpp"
+
+namespace
+{
+
+// 改为单次遍历之前的实现，原样保留作对照
+cv::Mat legacy_hwc_to_chw(const cv::Mat& src)
+{
+    std::vector<cv::Mat> rgb_images;
+    cv::split(src, rgb_images);
+
+    cv::Mat flat_r = rgb_images[0].reshape(1, 1);
+    cv::Mat flat_g = rgb_images[1].reshape(1, 1);
+    cv::Mat flat_b = rgb_images[2].reshape(1, 1);
+
+    cv::Mat matArray[] = { flat_r, flat_g, flat_b };
+
+    cv::Mat flat_image;
+    cv::hconcat(matArray, 3, flat_image);
+    return flat_image;
+}
+
+std::vector<float> legacy_image_to_tensor(const cv::Mat& image)
+{
+    cv::Mat src = image.clone();
+    cv::cvtColor(src, src, cv::COLOR_BGR2RGB);
+
+    cv::Mat chw = legacy_hwc_to_chw(src);
+    cv::Mat chw_32f;
+    chw.convertTo(chw_32f, CV_32F, 1.0 / 255.0);
+
+    size_t tensor_size = 1ULL * src.cols * src.rows * src.channels();
+    std::vector<float> tensor(tensor_size);
+    std::memcpy(tensor.data(), chw_32f.data, tensor_size * sizeof(float));
+    return tensor;
+}
+
+template <typename Func>
+double bench(int loops, Func&& func)
+{
+    func(); // 预热
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loops; ++i) {
+        func();
+    }
+    std::chrono::duration<double, std::micro> cost = std::chrono::steady_clock::now() - start;
+    return cost.count() / loops;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const int width = argc > 1 ? std::atoi(argv[1]) : 640;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 640;
+    const int loops = argc > 3 ? std::atoi(argv[3]) : 200;
+    if (width <= 0 || height <= 0 || loops <= 0) {
+        std::cerr << "usage: " << argv[0] << " [width] [height] [loops]" << std::endl;
+        return 1;
+    }
+
+    cv::Mat image(height, width, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    auto expected = legacy_image_to_tensor(image);
+    std::vector<float> tensor;
+    if (!MAA_VISION_NS::image_to_tensor(image, tensor) || tensor.size() != expected.size()) {
+        std::cerr << "size mismatch" << std::endl;
+        return 1;
+    }
+    for (size_t i = 0; i < tensor.size(); ++i) {
+        // 旧实现按 double 缩放再转 float，允许一点舍入误差
+        if (std::abs(tensor[i] - expected[i]) > 1e-6f) {
+            std::cerr << "value mismatch at " << i << ": " << tensor[i] << " vs " << expected[i] << std::endl;
+            return 1;
+        }
+    }
+
+    double legacy_cost = bench(loops, [&]() { return legacy_image_to_tensor(image); });
+    double fused_cost = bench(loops, [&]() { return MAA_VISION_NS::image_to_tensor(image, tensor); });
+    double fused_alloc_cost = bench(loops, [&]() { return MAA_VISION_NS::image_to_tensor(image); });
+
+    std::cout << width << "x" << height << ", " << loops << " loops" << std::endl;
+    std::cout << "legacy:              " << legacy_cost << " us" << std::endl;
+    std::cout << "fused (reused buff): " << fused_cost << " us" << std::endl;
+    std::cout << "fused (new vector):  " << fused_alloc_cost << " us" << std::endl;
+    std::cout << "speedup:             " << legacy_cost / fused_cost << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,543 @@
+// AdbWireIO 的测试：本地起一个假的 adb server，检查 transport、shell v2、exec、forward、sync 的协议细节，
+// 池里失效的连接会换新连接重试，设备没有 shell_v2 时交给 adb 进程
+// 用法: AdbWireIOTest
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Platform/AdbWireIO.h"
+#include "Utils/Boost.hpp"
+#include "Utils/Format.hpp"
+
+namespace
+{
+
+using namespace std::chrono_literals;
+using boost::asio::ip::tcp;
+
+const std::string kAdb = "adb";
+// 支持 shell_v2 的设备
+const std::string kSerial = "emulator-5554";
+// 没有 shell_v2 的老设备
+const std::string kOldSerial = "old-device";
+constexpr int64_t kTimeout = 5000;
+constexpr size_t kSyncMaxData = 64 * 1024;
+
+bool check(bool cond, const std::string& what)
+{
+    if (!cond) {
+        std::cerr << "failed: " << what << std::endl;
+    }
+    return cond;
+}
+
+std::string le32(uint32_t value)
+{
+    std::string result(4, '\0');
+    for (size_t i = 0; i != 4; ++i) {
+        result[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+    return result;
+}
+
+uint32_t from_le32(std::string_view data)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i != 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+std::string hex_string(std::string_view data)
+{
+    return MAA_FMT::format("{:04x}", data.size()) + std::string(data);
+}
+
+std::string shell_packet(char id, std::string_view data)
+{
+    return id + le32(static_cast<uint32_t>(data.size())) + std::string(data);
+}
+
+std::string sync_packet(std::string_view id, std::string_view data)
+{
+    return std::string(id) + le32(static_cast<uint32_t>(data.size())) + std::string(data);
+}
+
+std::string make_payload(size_t size)
+{
+    std::string result(size, '\0');
+    for (size_t i = 0; i != size; ++i) {
+        result[i] = static_cast<char>(i * 31 % 251);
+    }
+    return result;
+}
+
+std::optional<std::string> read_exact(tcp::socket& socket, size_t size)
+{
+    std::string result(size, '\0');
+    boost::system::error_code ec;
+    boost::asio::read(socket, boost::asio::buffer(result), ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+void write_all(tcp::socket& socket, std::string_view data)
+{
+    boost::system::error_code ec;
+    boost::asio::write(socket, boost::asio::buffer(data), ec);
+}
+
+void write_fail(tcp::socket& socket, std::string_view message)
+{
+    write_all(socket, "FAIL" + hex_string(message));
+}
+
+// 每条连接一个线程，同步读写；只实现被测对象用到的那部分协议
+class FakeAdbServer
+{
+public:
+    FakeAdbServer() : acceptor_(ios_, tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0))
+    {
+        accept_thread_ = std::thread(&FakeAdbServer::accepting, this);
+    }
+
+    ~FakeAdbServer()
+    {
+        // 连一下自己，把阻塞在 accept 的线程叫醒
+        stop_ = true;
+        boost::system::error_code ignored;
+        tcp::socket waker(ios_);
+        waker.connect(acceptor_.local_endpoint(), ignored);
+        accept_thread_.join();
+
+        for (auto& thread : serve_threads_) {
+            thread.join();
+        }
+    }
+
+    unsigned short port() const { return acceptor_.local_endpoint().port(); }
+
+    // 相当于设备重连，已切换到 transport 的连接再收到请求时直接断开
+    void drop_transports() { ++generation_; }
+
+    int idle_transports() const { return idle_transports_; }
+
+    int dropped() const { return dropped_; }
+
+    bool received(const std::string& service)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return std::find(services_.begin(), services_.end(), service) != services_.end();
+    }
+
+    std::optional<std::string> file(const std::string& path)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = files_.find(path);
+        return it == files_.end() ? std::nullopt : std::make_optional(it->second);
+    }
+
+    static std::string exec_payload() { return make_payload(200 * 1024); }
+
+private:
+    void accepting()
+    {
+        while (true) {
+            boost::system::error_code ec;
+            tcp::socket socket(ios_);
+            acceptor_.accept(socket, ec);
+            if (stop_) {
+                return;
+            }
+            if (ec) {
+                continue;
+            }
+            serve_threads_.emplace_back(&FakeAdbServer::serve, this, std::move(socket));
+        }
+    }
+
+    void serve(tcp::socket socket)
+    {
+        bool transport = false;
+        int transport_generation = 0;
+
+        while (true) {
+            if (transport) {
+                ++idle_transports_;
+            }
+            auto len = read_exact(socket, 4);
+            if (transport) {
+                --idle_transports_;
+            }
+            if (!len) {
+                return;
+            }
+            if (transport && transport_generation != generation_) {
+                ++dropped_;
+                return;
+            }
+
+            auto service = read_exact(socket, std::stoul(*len, nullptr, 16));
+            if (!service) {
+                return;
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                services_.emplace_back(*service);
+            }
+
+            if (!transport && service->starts_with("host:transport:")) {
+                auto serial = service->substr(std::string_view("host:transport:").size());
+                if (serial != kSerial && serial != kOldSerial) {
+                    write_fail(socket, "device '" + serial + "' not found");
+                    return;
+                }
+                write_all(socket, "OKAY");
+                transport = true;
+                transport_generation = generation_;
+                continue;
+            }
+            if (!transport && service->starts_with("host-serial:")) {
+                serve_host_serial(socket, service->substr(std::string_view("host-serial:").size()));
+                return;
+            }
+            if (transport && service->starts_with("shell,v2,raw:")) {
+                write_all(socket, "OKAY");
+                serve_shell(socket, service->substr(std::string_view("shell,v2,raw:").size()));
+                return;
+            }
+            if (transport && service->starts_with("exec:")) {
+                write_all(socket, "OKAY");
+                write_all(socket, exec_payload());
+                return;
+            }
+            if (transport && *service == "sync:") {
+                write_all(socket, "OKAY");
+                serve_sync(socket);
+                return;
+            }
+
+            write_fail(socket, "unknown service");
+            return;
+        }
+    }
+
+    void serve_host_serial(tcp::socket& socket, const std::string& request)
+    {
+        auto pos = request.find(':');
+        auto serial = request.substr(0, pos);
+        auto rest = request.substr(pos + 1);
+
+        if (rest == "features") {
+            write_all(socket, "OKAY" + hex_string(serial == kSerial ? "cmd,shell_v2,stat_v2" : "cmd"));
+            return;
+        }
+        if (rest.starts_with("forward:")) {
+            auto spec = rest.substr(std::string_view("forward:").size());
+            auto local = spec.substr(0, spec.find(';'));
+            auto remote = spec.substr(spec.find(';') + 1);
+            // 第一个 OKAY 表示收到请求，第二个才是 forward 的结果
+            write_all(socket, "OKAY");
+            if (remote == "tcp:refused") {
+                write_fail(socket, "cannot bind listener");
+                return;
+            }
+            write_all(socket, "OKAY");
+            if (local == "tcp:0") {
+                write_all(socket, hex_string("34567"));
+            }
+            return;
+        }
+        write_fail(socket, "unknown host service");
+    }
+
+    // stdout 分两个包，第一个包的头也拆开写；stderr 不应出现在输出里；"exit N" 的退出码是 N
+    void serve_shell(tcp::socket& socket, const std::string& command)
+    {
+        auto first = shell_packet(1, "out:");
+        write_all(socket, first.substr(0, 3));
+        std::this_thread::sleep_for(10ms);
+        write_all(socket, first.substr(3));
+        write_all(socket, shell_packet(1, command));
+        write_all(socket, shell_packet(2, "err"));
+
+        int code = command.starts_with("exit ") ? std::stoi(command.substr(5)) : 0;
+        write_all(socket, shell_packet(3, std::string(1, static_cast<char>(code))));
+    }
+
+    void serve_sync(tcp::socket& socket)
+    {
+        while (true) {
+            auto header = read_exact(socket, 8);
+            if (!header) {
+                return;
+            }
+            auto id = header->substr(0, 4);
+            auto len = from_le32(std::string_view(*header).substr(4));
+            if (id == "QUIT") {
+                return;
+            }
+
+            auto payload = read_exact(socket, len);
+            if (!payload) {
+                return;
+            }
+
+            if (id == "SEND") {
+                auto path = payload->substr(0, payload->rfind(','));
+                std::string content;
+                while (true) {
+                    auto data_header = read_exact(socket, 8);
+                    if (!data_header) {
+                        return;
+                    }
+                    if (data_header->starts_with("DONE")) {
+                        break;
+                    }
+                    auto data_len = from_le32(std::string_view(*data_header).substr(4));
+                    auto data = read_exact(socket, data_len);
+                    if (!data_header->starts_with("DATA") || data_len > kSyncMaxData || !data) {
+                        return;
+                    }
+                    content += *data;
+                }
+                if (path.starts_with("/system/")) {
+                    write_all(socket, sync_packet("FAIL", "Read-only file system"));
+                    return;
+                }
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    files_.insert_or_assign(path, std::move(content));
+                }
+                write_all(socket, "OKAY" + le32(0));
+            }
+            else if (id == "RECV") {
+                auto content = file(*payload);
+                if (!content) {
+                    write_all(socket, sync_packet("FAIL", "No such file or directory"));
+                    return;
+                }
+                for (size_t pos = 0; pos < content->size(); pos += kSyncMaxData) {
+                    write_all(socket, sync_packet("DATA", std::string_view(*content).substr(pos, kSyncMaxData)));
+                }
+                write_all(socket, "DONE" + le32(0));
+            }
+            else {
+                return;
+            }
+        }
+    }
+
+    boost::asio::io_context ios_;
+    tcp::acceptor acceptor_;
+    std::atomic_bool stop_ = false;
+    std::thread accept_thread_;
+    std::vector<std::thread> serve_threads_;
+
+    std::atomic_int generation_ = 0;
+    std::atomic_int idle_transports_ = 0;
+    std::atomic_int dropped_ = 0;
+
+    std::mutex mutex_;
+    std::vector<std::string> services_;
+    std::map<std::string, std::string> files_;
+};
+
+// 代替 adb 进程，只记录被调用了几次
+class FakeProcessIO : public MAA_CTRL_UNIT_NS::PlatformIO
+{
+public:
+    virtual int call_command(const std::vector<std::string>& cmd, bool, std::string& pipe_data, std::string&,
+                             int64_t) override
+    {
+        ++calls;
+        last_cmd = cmd;
+        pipe_data = "from process\n";
+        return 7;
+    }
+
+    virtual std::optional<unsigned short> create_socket(const std::string&) override { return std::nullopt; }
+
+    virtual void close_socket() noexcept override {}
+
+    virtual std::shared_ptr<MAA_CTRL_UNIT_NS::IOHandler> tcp(const std::string&, unsigned short) override
+    {
+        return nullptr;
+    }
+
+    virtual std::shared_ptr<MAA_CTRL_UNIT_NS::IOHandler> interactive_shell(const std::vector<std::string>&) override
+    {
+        ++interactive_calls;
+        return nullptr;
+    }
+
+    std::atomic_int calls = 0;
+    std::atomic_int interactive_calls = 0;
+    std::vector<std::string> last_cmd;
+};
+
+struct Fixture
+{
+    FakeAdbServer server;
+    std::shared_ptr<FakeProcessIO> process = std::make_shared<FakeProcessIO>();
+    MAA_CTRL_UNIT_NS::AdbWireIO io { process, kAdb, "127.0.0.1", server.port() };
+
+    int run(const std::vector<std::string>& cmd, std::string& output)
+    {
+        output.clear();
+        std::string sock_data;
+        return io.call_command(cmd, false, output, sock_data, kTimeout);
+    }
+};
+
+// 先 host:transport 切到设备，再走 shell v2；stderr 被丢掉，退出码取自 exit 包
+bool test_shell(Fixture& fixture)
+{
+    std::string output;
+    int ret = fixture.run({ kAdb, "-s", kSerial, "shell", "echo", "hello" }, output);
+    if (!check(ret == 0 && output == "out:echo hello", "shell output and exit code")) {
+        return false;
+    }
+
+    ret = fixture.run({ kAdb, "-s", kSerial, "shell", "exit 3" }, output);
+    return check(ret == 3 && output == "out:exit 3", "shell exit code comes from the exit packet") &&
+           check(fixture.server.received("host:transport:" + kSerial), "transport is requested") &&
+           check(fixture.server.received("shell,v2,raw:echo hello"), "shell args are joined") &&
+           check(fixture.process->calls == 0, "shell does not fall back");
+}
+
+// exec 没有退出码，读到对端关闭为止
+bool test_exec(Fixture& fixture)
+{
+    std::string output;
+    int ret = fixture.run({ kAdb, "-s", kSerial, "exec-out", "screencap", "-p" }, output);
+    return check(ret == 0, "exec succeeds") && check(output == FakeAdbServer::exec_payload(), "exec reads until eof") &&
+           check(fixture.server.received("exec:screencap -p"), "exec service") &&
+           check(fixture.process->calls == 0, "exec does not fall back");
+}
+
+// forward 要读两次状态，tcp:0 时还要读分配的端口
+bool test_forward(Fixture& fixture)
+{
+    std::string output;
+    int ret = fixture.run({ kAdb, "-s", kSerial, "forward", "tcp:1314", "tcp:1314" }, output);
+    if (!check(ret == 0 && output.empty(), "forward succeeds") ||
+        !check(fixture.server.received("host-serial:" + kSerial + ":forward:tcp:1314;tcp:1314"), "forward service")) {
+        return false;
+    }
+
+    ret = fixture.run({ kAdb, "-s", kSerial, "forward", "tcp:0", "tcp:1315" }, output);
+    if (!check(ret == 0 && output == "34567\n", "forward tcp:0 prints the allocated port")) {
+        return false;
+    }
+
+    ret = fixture.run({ kAdb, "-s", kSerial, "forward", "tcp:1316", "tcp:refused" }, output);
+    return check(ret == 1, "second FAIL status fails the forward") &&
+           check(fixture.process->calls == 0, "forward does not fall back");
+}
+
+// 超过一个 DATA 包的文件推上去再拉回来；FAIL 的消息带到输出里
+bool test_sync(Fixture& fixture)
+{
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto local = dir / "MaaAdbWireIOTest_push.bin";
+    const auto pulled = dir / "MaaAdbWireIOTest_pull.bin";
+    const auto content = make_payload(kSyncMaxData * 2 + 123);
+    {
+        std::ofstream ofs(local, std::ios::out | std::ios::binary);
+        ofs.write(content.data(), content.size());
+    }
+
+    std::string output;
+    int ret = fixture.run({ kAdb, "-s", kSerial, "push", local.string(), "/data/local/tmp/test.bin" }, output);
+    bool ok = check(ret == 0, "push succeeds") &&
+              check(fixture.server.file("/data/local/tmp/test.bin") == content, "pushed content arrives");
+
+    ret = fixture.run({ kAdb, "-s", kSerial, "pull", "/data/local/tmp/test.bin", pulled.string() }, output);
+    std::string pulled_content;
+    {
+        std::ifstream ifs(pulled, std::ios::in | std::ios::binary);
+        pulled_content.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+    ok = ok && check(ret == 0 && pulled_content == content, "pull gets the pushed content back");
+
+    ret = fixture.run({ kAdb, "-s", kSerial, "push", local.string(), "/system/test.bin" }, output);
+    ok = ok && check(ret == 1 && output.find("Read-only file system") != std::string::npos, "push FAIL is reported");
+
+    ret = fixture.run({ kAdb, "-s", kSerial, "pull", "/data/local/tmp/missing.bin", pulled.string() }, output);
+    ok = ok && check(ret == 1 && output.find("No such file") != std::string::npos, "pull FAIL is reported") &&
+         check(fixture.process->calls == 0, "sync does not fall back");
+
+    std::error_code ec;
+    std::filesystem::remove(local, ec);
+    std::filesystem::remove(pulled, ec);
+    return ok;
+}
+
+// 池里的连接被 server 断开后，请求失败要换一条新连接重来，而不是交给 adb 进程
+bool test_stale_pool(Fixture& fixture)
+{
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (fixture.server.idle_transports() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(10ms);
+    }
+    if (!check(fixture.server.idle_transports() > 0, "pool is refilled")) {
+        return false;
+    }
+
+    fixture.server.drop_transports();
+
+    std::string output;
+    int ret = fixture.run({ kAdb, "-s", kSerial, "shell", "echo", "again" }, output);
+    return check(ret == 0 && output == "out:echo again", "shell succeeds on a fresh connection") &&
+           check(fixture.server.dropped() > 0, "a stale pooled connection was tried") &&
+           check(fixture.process->calls == 0, "stale connection does not fall back");
+}
+
+// 没有 shell_v2 拿不到退出码，shell 和交互式 shell 都交给 adb 进程
+bool test_fallback(Fixture& fixture)
+{
+    std::string output;
+    const std::vector<std::string> cmd = { kAdb, "-s", kOldSerial, "shell", "echo", "hello" };
+    int ret = fixture.run(cmd, output);
+    if (!check(ret == 7 && output == "from process\n", "shell falls back to the adb process") ||
+        !check(fixture.process->calls == 1 && fixture.process->last_cmd == cmd, "fallback gets the original argv")) {
+        return false;
+    }
+
+    fixture.io.interactive_shell(cmd);
+    return check(fixture.process->interactive_calls == 1, "interactive shell falls back") &&
+           check(!fixture.server.received("host:transport:" + kOldSerial), "old device gets no transport");
+}
+
+}
+
+int main()
+{
+    Fixture fixture;
+
+    bool ok = test_shell(fixture) && test_exec(fixture) && test_forward(fixture) && test_sync(fixture) &&
+              test_stale_pool(fixture) && test_fallback(fixture);
+    if (!ok) {
+        return 1;
+    }
+
+    std::cout << "all AdbWireIO tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,129 @@
+// InitScheduler 的测试：依赖失败时跳过、互不依赖的步骤并发执行、报告内容
+// 用法: InitSchedulerTest
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "Utils/InitScheduler.hpp"
+
+namespace
+{
+
+using namespace std::chrono_literals;
+
+bool check(bool cond, const std::string& what)
+{
+    if (!cond) {
+        std::cerr << "failed: " << what << std::endl;
+    }
+    return cond;
+}
+
+const MAA_NS::InitScheduler::StepReport* find_report(const MAA_NS::InitScheduler& scheduler, const std::string& name)
+{
+    for (const auto& report : scheduler.report()) {
+        if (report.name == name) {
+            return &report;
+        }
+    }
+    return nullptr;
+}
+
+// 失败和抛异常的步骤，依赖它们的不执行，间接依赖的也不执行；不相关的照常执行
+bool test_dependency_skip()
+{
+    std::atomic_int executed = 0;
+    auto ok = [&]() {
+        ++executed;
+        return true;
+    };
+
+    MAA_NS::InitScheduler scheduler;
+    bool added = scheduler.add("Root", ok) && scheduler.add("Fail", []() { return false; }, { "Root" }) &&
+                 scheduler.add("Throw", []() -> bool { throw std::runtime_error("boom"); }, { "Root" }) &&
+                 scheduler.add("AfterFail", ok, { "Fail" }) && scheduler.add("AfterThrow", ok, { "Throw" }) &&
+                 scheduler.add("Transitive", ok, { "AfterFail" }) && scheduler.add("Sibling", ok, { "Root" });
+    if (!check(added, "add steps")) {
+        return false;
+    }
+
+    bool ret = scheduler.run();
+
+    const auto* after_fail = find_report(scheduler, "AfterFail");
+    const auto* transitive = find_report(scheduler, "Transitive");
+    const auto* throw_step = find_report(scheduler, "Throw");
+    return check(!ret, "run fails when a step fails") && check(executed == 2, "only Root and Sibling run ok steps") &&
+           check(scheduler.succeeded("Root") && scheduler.succeeded("Sibling"), "independent steps succeed") &&
+           check(!scheduler.succeeded("Fail") && !scheduler.succeeded("Throw"), "failed steps are reported") &&
+           check(throw_step && throw_step->executed, "throwing step counts as executed") &&
+           check(after_fail && !after_fail->executed, "dependent of failed step is skipped") &&
+           check(transitive && !transitive->executed, "transitive dependent is skipped") &&
+           check(!scheduler.succeeded("AfterThrow"), "dependent of throwing step is skipped");
+}
+
+// 两个互不依赖的步骤互相等对方开始，串行执行的话会超时
+bool test_concurrency()
+{
+    std::atomic_int started = 0;
+    auto rendezvous = [&]() {
+        ++started;
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (started < 2) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    };
+
+    MAA_NS::InitScheduler scheduler;
+    scheduler.add("Connect", []() { return true; });
+    scheduler.add("Left", rendezvous, { "Connect" });
+    scheduler.add("Right", rendezvous, { "Connect" });
+    bool ret = scheduler.run();
+
+    return check(ret, "independent steps run concurrently") &&
+           check(scheduler.total() < 5s, "total is shorter than the rendezvous timeout");
+}
+
+// 依赖的步骤结束后才开始，报告按添加顺序，耗时和开始时间合理
+bool test_report()
+{
+    MAA_NS::InitScheduler scheduler;
+    scheduler.add("Slow", []() {
+        std::this_thread::sleep_for(100ms);
+        return true;
+    });
+    scheduler.add("Next", []() { return true; }, { "Slow" });
+    bool ret = scheduler.run();
+
+    const auto& report = scheduler.report();
+    bool ordered = report.size() == 2 && report[0].name == "Slow" && report[1].name == "Next";
+    if (!check(ret, "run succeeds") || !check(ordered, "report is in insertion order")) {
+        return false;
+    }
+    return check(report[0].executed && report[0].success, "Slow is reported as succeeded") &&
+           check(report[0].cost >= 100ms, "Slow cost covers its sleep") &&
+           check(report[1].start >= report[0].start + report[0].cost, "Next starts after Slow ends") &&
+           check(scheduler.total() >= report[1].start + report[1].cost, "total covers every step") &&
+           check(!scheduler.add("Slow", []() { return true; }), "duplicate name is rejected") &&
+           check(!scheduler.add("Orphan", []() { return true; }, { "Unknown" }), "unknown dependency is rejected");
+}
+
+}
+
+int main()
+{
+    bool ok = test_dependency_skip() && test_concurrency() && test_report();
+    if (!ok) {
+        return 1;
+    }
+
+    std::cout << "all InitScheduler tests passed" << std::endl;
+    return 0;
+}
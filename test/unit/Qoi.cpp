@@ -0,0 +1,180 @@
+// encode_qoi 的往返测试：按 QOI 规范独立实现的解码器能否还原出原图
+// 用法: QoiTest
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Utils/NoWarningCV.hpp"
+#include "Utils/Qoi.hpp"
+
+namespace
+{
+
+// 照 https://qoiformat.org/qoi-specification.pdf 写的解码器，只输出 3 通道，不复用编码器的任何代码
+std::optional<cv::Mat> decode_qoi(const std::vector<uint8_t>& data)
+{
+    struct Pixel
+    {
+        uint8_t r = 0;
+        uint8_t g = 0;
+        uint8_t b = 0;
+        uint8_t a = 0;
+    };
+
+    constexpr size_t kHeaderSize = 14;
+    constexpr size_t kEndSize = 8;
+    if (data.size() < kHeaderSize + kEndSize || data[0] != 'q' || data[1] != 'o' || data[2] != 'i' || data[3] != 'f') {
+        return std::nullopt;
+    }
+
+    auto read_u32 = [&](size_t pos) {
+        return static_cast<uint32_t>(data[pos]) << 24 | static_cast<uint32_t>(data[pos + 1]) << 16 |
+               static_cast<uint32_t>(data[pos + 2]) << 8 | static_cast<uint32_t>(data[pos + 3]);
+    };
+    const int width = static_cast<int>(read_u32(4));
+    const int height = static_cast<int>(read_u32(8));
+    if (data[12] != 3) {
+        return std::nullopt;
+    }
+
+    cv::Mat image(height, width, CV_8UC3);
+
+    std::array<Pixel, 64> index {};
+    Pixel px { .r = 0, .g = 0, .b = 0, .a = 255 };
+    int run = 0;
+    size_t pos = kHeaderSize;
+    const size_t chunks_end = data.size() - kEndSize;
+
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = image.ptr<uint8_t>(y);
+        for (int x = 0; x < width; ++x) {
+            if (run > 0) {
+                --run;
+            }
+            else if (pos < chunks_end) {
+                const uint8_t b1 = data[pos++];
+                if (b1 == 0xfe) {
+                    px.r = data[pos++];
+                    px.g = data[pos++];
+                    px.b = data[pos++];
+                }
+                else if (b1 == 0xff) {
+                    px.r = data[pos++];
+                    px.g = data[pos++];
+                    px.b = data[pos++];
+                    px.a = data[pos++];
+                }
+                else if ((b1 & 0xc0) == 0x00) {
+                    px = index[b1];
+                }
+                else if ((b1 & 0xc0) == 0x40) {
+                    px.r += ((b1 >> 4) & 0x03) - 2;
+                    px.g += ((b1 >> 2) & 0x03) - 2;
+                    px.b += (b1 & 0x03) - 2;
+                }
+                else if ((b1 & 0xc0) == 0x80) {
+                    const uint8_t b2 = data[pos++];
+                    const int vg = (b1 & 0x3f) - 32;
+                    px.r += vg - 8 + ((b2 >> 4) & 0x0f);
+                    px.g += vg;
+                    px.b += vg - 8 + (b2 & 0x0f);
+                }
+                else {
+                    run = b1 & 0x3f;
+                }
+                index[(px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64] = px;
+            }
+            else {
+                return std::nullopt;
+            }
+
+            row[x * 3] = px.b;
+            row[x * 3 + 1] = px.g;
+            row[x * 3 + 2] = px.r;
+        }
+    }
+
+    if (pos != chunks_end) {
+        return std::nullopt;
+    }
+    return image;
+}
+
+bool round_trip(const std::string& name, const cv::Mat& image)
+{
+    auto decoded = decode_qoi(MAA_NS::encode_qoi(image));
+    if (!decoded) {
+        std::cerr << name << ": malformed stream" << std::endl;
+        return false;
+    }
+    if (decoded->size() != image.size() || cv::norm(*decoded, image, cv::NORM_INF) != 0) {
+        std::cerr << name << ": decoded image differs" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main()
+{
+    std::mt19937 rng(20231018);
+
+    // 随机噪声，主要走 RGB 分支
+    cv::Mat noise(48, 64, CV_8UC3);
+    cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    // 黑色会撞上 alpha 为 0 的初始 index 项；alpha 弄错时，紧跟其后的 DIFF 像素在解码端会落进另一个 index 位置，
+    // 之后再用 INDEX 引用它就会解错
+    const std::array<cv::Vec3b, 5> cycle = {
+        cv::Vec3b(10, 200, 30), cv::Vec3b(0, 0, 0), cv::Vec3b(1, 1, 1), cv::Vec3b(10, 200, 30), cv::Vec3b(1, 1, 1),
+    };
+    cv::Mat black_cycle(32, 33, CV_8UC3);
+    for (int y = 0; y < black_cycle.rows; ++y) {
+        for (int x = 0; x < black_cycle.cols; ++x) {
+            black_cycle.at<cv::Vec3b>(y, x) = cycle[x % cycle.size()];
+        }
+    }
+
+    // 相邻像素差很小，走 DIFF 和 LUMA 分支
+    cv::Mat gradient(40, 70, CV_8UC3);
+    for (int y = 0; y < gradient.rows; ++y) {
+        for (int x = 0; x < gradient.cols; ++x) {
+            gradient.at<cv::Vec3b>(y, x) = cv::Vec3b(static_cast<uint8_t>(x * 3 + y), static_cast<uint8_t>(x + y * 5),
+                                                     static_cast<uint8_t>(x * 7 - y * 2));
+        }
+    }
+
+    // 超过 62 个像素的游程
+    cv::Mat runs(10, 200, CV_8UC3, cv::Scalar(1, 2, 3));
+    for (int i = 0; i < 40; ++i) {
+        runs.at<cv::Vec3b>(static_cast<int>(rng() % runs.rows), static_cast<int>(rng() % runs.cols)) =
+            cv::Vec3b(static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()));
+    }
+
+    // 少量颜色反复出现，大量命中 INDEX
+    const std::array<cv::Vec3b, 5> palette = {
+        cv::Vec3b(0, 0, 0), cv::Vec3b(255, 255, 255), cv::Vec3b(0, 0, 255), cv::Vec3b(0, 128, 0), cv::Vec3b(90, 90, 90),
+    };
+    cv::Mat few_colors(50, 50, CV_8UC3);
+    for (int y = 0; y < few_colors.rows; ++y) {
+        for (int x = 0; x < few_colors.cols; ++x) {
+            few_colors.at<cv::Vec3b>(y, x) = palette[rng() % palette.size()];
+        }
+    }
+
+    bool ok = round_trip("noise", noise) && round_trip("black_cycle", black_cycle) &&
+              round_trip("gradient", gradient) && round_trip("runs", runs) && round_trip("few_colors", few_colors) &&
+              round_trip("non_continuous", noise(cv::Rect(5, 3, 40, 30)));
+    if (!ok) {
+        return 1;
+    }
+
+    std::cout << "all round trips passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,219 @@
+// ScreencapRawStream 的测试：自身冒充 adb，forward 直接成功，shell 在本地端口上推几帧带 MAAFRAME 的 raw 数据，
+// 最后一帧只推一半，然后断开。检查 screencap 拿到的是最新的完整帧，流断开后返回 nullopt
+// 用法: RawStreamTest
+//       RawStreamTest -s <serial> <forward|shell> ...    被测对象调用的假 adb
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <meojson/json.hpp>
+
+#include "Platform/BoostIO.h"
+#include "Screencap/RawStream.h"
+#include "Utils/Boost.hpp"
+#include "Utils/NoWarningCV.hpp"
+
+namespace
+{
+
+using namespace std::chrono_literals;
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+// 与 RawStream.cpp 中的端口一致
+constexpr unsigned short kStreamPort = 1314;
+// 推完数据后保持连接的时间，测试在这段时间里检查最新帧
+constexpr auto kHoldTime = 3s;
+
+struct Rgb
+{
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+};
+
+constexpr std::array<Rgb, 4> kFrames = {
+    Rgb { 200, 30, 10 },
+    Rgb { 20, 180, 40 },
+    Rgb { 60, 70, 220 },
+    Rgb { 90, 150, 120 },
+};
+constexpr Rgb kPartialFrame = { 250, 250, 0 };
+
+bool check(bool cond, const std::string& what)
+{
+    if (!cond) {
+        std::cerr << "failed: " << what << std::endl;
+    }
+    return cond;
+}
+
+void append_u32(std::string& out, uint32_t value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// 新版 screencap 的格式：width, height, format, colorspace 四个 u32 头，之后是 RGBA
+std::string make_frame(const Rgb& color)
+{
+    std::string frame = "MAAFRAME";
+    append_u32(frame, kWidth);
+    append_u32(frame, kHeight);
+    append_u32(frame, 1);
+    append_u32(frame, 0);
+    for (int i = 0; i < kWidth * kHeight; ++i) {
+        frame.push_back(static_cast<char>(color.r));
+        frame.push_back(static_cast<char>(color.g));
+        frame.push_back(static_cast<char>(color.b));
+        frame.push_back(static_cast<char>(255));
+    }
+    return frame;
+}
+
+// 相当于设备端的 nc -l 加上本地的 adb forward
+int fake_stream()
+{
+    // 被测对象出错没有结束这个进程时自行退出
+    std::thread([]() {
+        std::this_thread::sleep_for(30s);
+        std::_Exit(2);
+    }).detach();
+
+    using namespace boost::asio::ip;
+
+    boost::asio::io_context ios;
+    tcp::acceptor acceptor(ios);
+    tcp::endpoint endpoint(address::from_string("127.0.0.1"), kStreamPort);
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(tcp::acceptor::reuse_address(true));
+    acceptor.bind(endpoint);
+    acceptor.listen();
+
+    tcp::socket socket = acceptor.accept();
+
+    std::string data;
+    for (const auto& color : kFrames) {
+        data.append(make_frame(color));
+    }
+    std::string partial = make_frame(kPartialFrame);
+    data.append(partial.substr(0, partial.size() / 2));
+    boost::asio::write(socket, boost::asio::buffer(data));
+
+    std::this_thread::sleep_for(kHoldTime);
+    return 0;
+}
+
+int fake_adb(std::string_view command)
+{
+    if (command == "forward") {
+        return 0;
+    }
+    if (command == "shell") {
+        return fake_stream();
+    }
+    std::cerr << "fake adb: unexpected command " << command << std::endl;
+    return 1;
+}
+
+bool same_color(const cv::Mat& image, const Rgb& color)
+{
+    const cv::Vec3b expected(color.b, color.g, color.r);
+    return image.cols == kWidth && image.rows == kHeight && image.type() == CV_8UC3 &&
+           image.at<cv::Vec3b>(0, 0) == expected && image.at<cv::Vec3b>(kHeight - 1, kWidth - 1) == expected;
+}
+
+bool is_sent_frame(const cv::Mat& image)
+{
+    for (const auto& color : kFrames) {
+        if (same_color(image, color)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 完整的帧都已推完，最新的是最后一个完整帧；只推了一半的那帧不能出现
+bool test_newest_frame(MAA_CTRL_UNIT_NS::ScreencapRawStream& unit)
+{
+    auto deadline = std::chrono::steady_clock::now() + kHoldTime / 2;
+    while (std::chrono::steady_clock::now() < deadline) {
+        auto image = unit.screencap();
+        if (!check(image.has_value(), "screencap while the stream is open")) {
+            return false;
+        }
+        if (!check(is_sent_frame(*image), "screencap returns a complete frame")) {
+            return false;
+        }
+        if (same_color(*image, kFrames.back())) {
+            auto again = unit.screencap();
+            return check(again && same_color(*again, kFrames.back()), "newest frame stays until a newer one");
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+    return check(false, "newest complete frame arrives");
+}
+
+// 对端断开后 reader 退出，screencap 不再返回旧帧
+bool test_stream_end(MAA_CTRL_UNIT_NS::ScreencapRawStream& unit)
+{
+    auto deadline = std::chrono::steady_clock::now() + kHoldTime + 5s;
+    while (std::chrono::steady_clock::now() < deadline) {
+        auto image = unit.screencap();
+        if (!image) {
+            return true;
+        }
+        if (!check(is_sent_frame(*image), "screencap returns a complete frame before the stream ends")) {
+            return false;
+        }
+        std::this_thread::sleep_for(100ms);
+    }
+    return check(false, "screencap returns nullopt after the stream ends");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 3 && std::string_view(argv[1]) == "-s") {
+        return fake_adb(argv[3]);
+    }
+
+    using namespace MAA_CTRL_UNIT_NS;
+
+    // 与 controller_config.json 中的一致，假 adb 不关心 shell 的内容
+    json::value config = json::object {
+        { "argv",
+          json::object {
+              { "ScreencapRawStream",
+                json::array { "{ADB}", "-s", "{ADB_SERIAL}", "shell",
+                              "while true; do echo -n MAAFRAME; screencap; done | nc -l -p {REMOTE_PORT}" } },
+              { "ForwardTcp",
+                json::array { "{ADB}", "-s", "{ADB_SERIAL}", "forward", "tcp:{FOWARD_PORT}", "tcp:{REMOTE_PORT}" } },
+          } },
+    };
+
+    ScreencapRawStream unit;
+    if (!check(unit.parse(config), "parse config")) {
+        return 1;
+    }
+    unit.set_io(std::make_shared<BoostIO>());
+    unit.set_replacement({
+        { "{ADB}", std::filesystem::absolute(argv[0]).string() },
+        { "{ADB_SERIAL}", "fake" },
+    });
+
+    bool ok = check(unit.init(kWidth, kHeight), "init") && test_newest_frame(unit) && test_stream_end(unit);
+    if (!ok) {
+        return 1;
+    }
+
+    std::cout << "all RawStream tests passed" << std::endl;
+    return 0;
+}
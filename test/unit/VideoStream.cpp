@@ -0,0 +1,355 @@
+// ScreencapVideoStream 的测试：自身冒充 adb，forward 直接成功，shell 在本地端口上推一段现场生成的 H.264 流。
+// 流的开头是一批不会输出的帧，几秒后才是能显示的 IDR 帧，最后断开。
+// 检查首帧超时返回 nullopt、等待中到达的首帧能拿到、流结束后返回 nullopt
+// 用法: VideoStreamTest
+//       VideoStreamTest -s <serial> <forward|shell> ...    被测对象调用的假 adb
+
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <meojson/json.hpp>
+
+#include "Platform/BoostIO.h"
+#include "Screencap/VideoStream.h"
+#include "Utils/Boost.hpp"
+#include "Utils/NoWarningCV.hpp"
+
+namespace
+{
+
+using namespace std::chrono_literals;
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+// 与 VideoStream.cpp 中的端口一致
+constexpr unsigned short kStreamPort = 1315;
+// 与 VideoStream.cpp 中的首帧超时一致
+constexpr auto kFrameTimeout = 5s;
+// 探测用的帧数，要足够 videoio 在 open 里分析出流的参数
+constexpr int kProbeFrames = 120;
+constexpr int kShownFrames = 10;
+// 开始推流后多久才推能显示的帧，要比 open 的耗时加上首帧超时更长
+constexpr auto kFirstFrameDelay = 7s;
+// 推完能显示的帧后保持连接的时间
+constexpr auto kHoldTime = 2s;
+
+struct Rgb
+{
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+};
+
+constexpr Rgb kHiddenColor = { 200, 30, 10 };
+constexpr Rgb kShownColor = { 20, 180, 40 };
+
+bool check(bool cond, const std::string& what)
+{
+    if (!cond) {
+        std::cerr << "failed: " << what << std::endl;
+    }
+    return cond;
+}
+
+// 按位写 RBSP，生成 NAL 时加上起始码和防竞争字节
+class BitWriter
+{
+public:
+    void bits(uint32_t value, int count)
+    {
+        for (int i = count - 1; i >= 0; --i) {
+            bits_.push_back((value >> i) & 1);
+        }
+    }
+
+    void ue(uint32_t value)
+    {
+        ++value;
+        int len = std::bit_width(value);
+        bits(0, len - 1);
+        bits(value, len);
+    }
+
+    void se(int32_t value) { ue(static_cast<uint32_t>(value > 0 ? 2 * value - 1 : -2 * value)); }
+
+    void align()
+    {
+        while (bits_.size() % 8 != 0) {
+            bits_.push_back(false);
+        }
+    }
+
+    void trailing()
+    {
+        bits_.push_back(true);
+        align();
+    }
+
+    std::string nal(uint8_t header) const
+    {
+        std::string result("\0\0\0\1", 4);
+        result.push_back(static_cast<char>(header));
+
+        int zeros = 0;
+        for (size_t i = 0; i < bits_.size(); i += 8) {
+            uint8_t byte = 0;
+            for (size_t j = 0; j != 8; ++j) {
+                byte = static_cast<uint8_t>(byte << 1 | bits_[i + j]);
+            }
+            if (zeros >= 2 && byte <= 3) {
+                result.push_back(3);
+                zeros = 0;
+            }
+            result.push_back(static_cast<char>(byte));
+            zeros = byte == 0 ? zeros + 1 : 0;
+        }
+        return result;
+    }
+
+private:
+    std::vector<bool> bits_;
+};
+
+// Baseline，POC type 2，没有参考帧，所以解码顺序就是输出顺序，也不会有输出延迟
+std::string sps()
+{
+    BitWriter w;
+    w.bits(66, 8);          // profile_idc
+    w.bits(0xc0, 8);        // constraint_set0_flag, constraint_set1_flag
+    w.bits(30, 8);          // level_idc
+    w.ue(0);                // seq_parameter_set_id
+    w.ue(0);                // log2_max_frame_num_minus4
+    w.ue(2);                // pic_order_cnt_type
+    w.ue(0);                // max_num_ref_frames
+    w.bits(0, 1);           // gaps_in_frame_num_value_allowed_flag
+    w.ue(kWidth / 16 - 1);  // pic_width_in_mbs_minus1
+    w.ue(kHeight / 16 - 1); // pic_height_in_map_units_minus1
+    w.bits(1, 1);           // frame_mbs_only_flag
+    w.bits(1, 1);           // direct_8x8_inference_flag
+    w.bits(0, 1);           // frame_cropping_flag
+    w.bits(0, 1);           // vui_parameters_present_flag
+    w.trailing();
+    return w.nal(0x67);
+}
+
+std::string pps()
+{
+    BitWriter w;
+    w.ue(0);      // pic_parameter_set_id
+    w.ue(0);      // seq_parameter_set_id
+    w.bits(0, 1); // entropy_coding_mode_flag
+    w.bits(0, 1); // bottom_field_pic_order_in_frame_present_flag
+    w.ue(0);      // num_slice_groups_minus1
+    w.ue(0);      // num_ref_idx_l0_default_active_minus1
+    w.ue(0);      // num_ref_idx_l1_default_active_minus1
+    w.bits(0, 1); // weighted_pred_flag
+    w.bits(0, 2); // weighted_bipred_idc
+    w.se(0);      // pic_init_qp_minus26
+    w.se(0);      // pic_init_qs_minus26
+    w.se(0);      // chroma_qp_index_offset
+    w.bits(0, 1); // deblocking_filter_control_present_flag
+    w.bits(0, 1); // constrained_intra_pred_flag
+    w.bits(0, 1); // redundant_pic_cnt_present_flag
+    w.trailing();
+    return w.nal(0x68);
+}
+
+// 整帧都是 I_PCM 宏块，解码结果就是写进去的样本。
+// IDR 帧正常输出；IDR 之前不作参考的 I 帧会被解码器丢掉，但足够 open 时分析出流的参数
+std::string picture(const Rgb& color, bool idr, uint32_t idr_pic_id)
+{
+    // BT.601 limited range，与解码端转回 BGR 时一致
+    auto sample = [&](double base, double kr, double kg, double kb) {
+        return static_cast<uint32_t>(std::lround(base + (kr * color.r + kg * color.g + kb * color.b) / 255));
+    };
+    const uint32_t y = sample(16, 65.481, 128.553, 24.966);
+    const uint32_t u = sample(128, -37.797, -74.203, 112.0);
+    const uint32_t v = sample(128, 112.0, -93.786, -18.214);
+
+    BitWriter w;
+    w.ue(0);      // first_mb_in_slice
+    w.ue(7);      // slice_type: I
+    w.ue(0);      // pic_parameter_set_id
+    w.bits(0, 4); // frame_num
+    if (idr) {
+        w.ue(idr_pic_id);
+        w.bits(0, 1); // no_output_of_prior_pics_flag
+        w.bits(0, 1); // long_term_reference_flag
+    }
+    w.se(0); // slice_qp_delta
+
+    for (int mb = 0; mb != (kWidth / 16) * (kHeight / 16); ++mb) {
+        w.ue(25); // mb_type: I_PCM
+        w.align();
+        for (int i = 0; i != 256; ++i) {
+            w.bits(y, 8);
+        }
+        for (int i = 0; i != 64; ++i) {
+            w.bits(u, 8);
+        }
+        for (int i = 0; i != 64; ++i) {
+            w.bits(v, 8);
+        }
+    }
+    w.trailing();
+
+    // nal_ref_idc 3 的 IDR；nal_ref_idc 0 的非 IDR
+    return w.nal(idr ? 0x65 : 0x01);
+}
+
+// 相当于设备端的 screenrecord | nc -l 加上本地的 adb forward
+int fake_stream()
+{
+    // 被测对象出错没有结束这个进程时自行退出
+    std::thread([]() {
+        std::this_thread::sleep_for(60s);
+        std::_Exit(2);
+    }).detach();
+
+    using namespace boost::asio::ip;
+
+    boost::asio::io_context ios;
+    tcp::acceptor acceptor(ios);
+    tcp::endpoint endpoint(address::from_string("127.0.0.1"), kStreamPort);
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(tcp::acceptor::reuse_address(true));
+    acceptor.bind(endpoint);
+    acceptor.listen();
+
+    tcp::socket socket = acceptor.accept();
+
+    std::string data = sps() + pps();
+    const std::string hidden = picture(kHiddenColor, false, 0);
+    for (int i = 0; i != kProbeFrames; ++i) {
+        data.append(hidden);
+    }
+    boost::asio::write(socket, boost::asio::buffer(data));
+
+    std::this_thread::sleep_for(kFirstFrameDelay);
+
+    data.clear();
+    for (int i = 0; i != kShownFrames; ++i) {
+        // 相邻的 IDR 帧 idr_pic_id 不能相同
+        data.append(picture(kShownColor, true, i % 2));
+    }
+    boost::asio::write(socket, boost::asio::buffer(data));
+
+    std::this_thread::sleep_for(kHoldTime);
+    return 0;
+}
+
+int fake_adb(std::string_view command)
+{
+    if (command == "forward") {
+        return 0;
+    }
+    if (command == "shell") {
+        return fake_stream();
+    }
+    std::cerr << "fake adb: unexpected command " << command << std::endl;
+    return 1;
+}
+
+// 解码后转 BGR 有舍入误差
+bool near_color(const cv::Mat& image, const Rgb& color)
+{
+    if (image.cols != kWidth || image.rows != kHeight || image.type() != CV_8UC3) {
+        return false;
+    }
+    const cv::Scalar expected(color.b, color.g, color.r);
+    cv::Mat diff;
+    cv::absdiff(image, expected, diff);
+    double max_diff = 0;
+    cv::minMaxLoc(diff.reshape(1), nullptr, &max_diff);
+    return max_diff <= 4;
+}
+
+using Clock = std::chrono::steady_clock;
+
+// 流已打开但还没有能显示的帧时，screencap 等满首帧超时后返回 nullopt；等待中到达的首帧能拿到
+bool test_first_frame(MAA_CTRL_UNIT_NS::ScreencapVideoStream& unit, Clock::time_point init_end)
+{
+    auto start = Clock::now();
+    auto image = unit.screencap();
+    auto cost = Clock::now() - start;
+    if (!check(!image, "screencap returns nullopt before the first frame") ||
+        !check(cost >= kFrameTimeout - 500ms && cost < kFirstFrameDelay, "screencap waits the first frame timeout")) {
+        return false;
+    }
+
+    image = unit.screencap();
+    return check(image && near_color(*image, kShownColor), "first frame is delivered while screencap waits") &&
+           check(Clock::now() - init_end < kFirstFrameDelay + 3s, "first frame arrives in time");
+}
+
+// 流结束后不能再把最后一帧当作当前画面
+bool test_stream_end(MAA_CTRL_UNIT_NS::ScreencapVideoStream& unit)
+{
+    auto deadline = Clock::now() + kHoldTime + kFrameTimeout + 5s;
+    while (Clock::now() < deadline) {
+        auto image = unit.screencap();
+        if (!image) {
+            return true;
+        }
+        if (!check(near_color(*image, kShownColor), "only the shown frames are delivered")) {
+            return false;
+        }
+        std::this_thread::sleep_for(100ms);
+    }
+    return check(false, "screencap returns nullopt after the stream ends");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 3 && std::string_view(argv[1]) == "-s") {
+        return fake_adb(argv[3]);
+    }
+
+    using namespace MAA_CTRL_UNIT_NS;
+
+    // 与 controller_config.json 中的一致，假 adb 不关心 shell 的内容
+    json::value config = json::object {
+        { "argv",
+          json::object {
+              { "ScreencapVideoStream",
+                json::array { "{ADB}", "-s", "{ADB_SERIAL}", "shell",
+                              "while true; do screenrecord --output-format=h264 -; done | nc -l -p {REMOTE_PORT}" } },
+              { "ForwardTcp",
+                json::array { "{ADB}", "-s", "{ADB_SERIAL}", "forward", "tcp:{FOWARD_PORT}", "tcp:{REMOTE_PORT}" } },
+          } },
+    };
+
+    ScreencapVideoStream unit;
+    if (!check(unit.parse(config), "parse config")) {
+        return 1;
+    }
+    unit.set_io(std::make_shared<BoostIO>());
+    unit.set_replacement({
+        { "{ADB}", std::filesystem::absolute(argv[0]).string() },
+        { "{ADB_SERIAL}", "fake" },
+    });
+
+    if (!check(unit.init(kWidth, kHeight), "init")) {
+        return 1;
+    }
+    auto init_end = Clock::now();
+
+    bool ok = test_first_frame(unit, init_end) && test_stream_end(unit);
+    if (!ok) {
+        return 1;
+    }
+
+    std::cout << "all VideoStream tests passed" << std::endl;
+    return 0;
+}